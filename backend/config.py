@@ -16,7 +16,7 @@ class Settings(BaseSettings):
     
     # Storage Settings
     audio_storage_path: str = "./audio_storage"
-    max_chunk_size_mb: int = 10
+    max_chunk_size_mb: int = 10  # the plugin keeps encoded chunks under 8 MB
     
     # Authentication
     # In production, use environment variables and secure password hashing
@@ -27,6 +27,7 @@ class Settings(BaseSettings):
     # Session Settings
     session_timeout_minutes: int = 60
     auto_finalize_on_timeout: bool = True
+    max_open_sessions_per_user: int = 8
     
     class Config:
         env_file = ".env"
@@ -1,16 +1,28 @@
-from fastapi import FastAPI, File, UploadFile, Depends, HTTPException, status
+from fastapi import FastAPI, Request, Depends, HTTPException, Header, status
 from fastapi.security import HTTPBasic, HTTPBasicCredentials
-from fastapi.responses import FileResponse
+from fastapi.responses import FileResponse, Response
+from fastapi.concurrency import run_in_threadpool
+from pydantic import BaseModel
 from typing import List, Optional
 import secrets
 import os
 import uuid
-import wave
+import wavfile
 import io
+import struct
+import zlib
 import logging
+import soundfile
+import threading
+import time
+import asyncio
+from contextlib import asynccontextmanager, contextmanager
 from pathlib import Path
 from datetime import datetime
 
+from peaks import PeakBuilder
+from config import settings
+
 # Configure logging
 logging.basicConfig(
     level=logging.INFO,
@@ -18,13 +30,33 @@ logging.basicConfig(
 )
 logger = logging.getLogger(__name__)
 
-app = FastAPI(title="Auxlee Audio API", version="1.0.0")
+
+@asynccontextmanager
+async def lifespan(app: FastAPI):
+    """Clear out what a previous run left behind, then keep reaping idle sessions"""
+    await run_in_threadpool(session_manager.remove_orphaned_sessions)
+    reaper = asyncio.create_task(reap_idle_sessions_periodically())
+    yield
+    reaper.cancel()
+
+
+app = FastAPI(title="Auxlee Audio API", version="1.0.0", lifespan=lifespan)
 security = HTTPBasic()
 
 # Configuration
 AUDIO_STORAGE_PATH = Path("./audio_storage")
 AUDIO_STORAGE_PATH.mkdir(exist_ok=True)
 
+# Uploads are streamed to disk in pieces of this size, so a request never
+# holds more than this in memory (apart from decoding a lossy chunk)
+INGEST_PIECE_BYTES = 64 * 1024
+MAX_CHUNK_BYTES = settings.max_chunk_size_mb * 1024 * 1024
+
+# Sessions untouched for this long are finalized or expired by the reaper,
+# which checks every REAP_INTERVAL_SECONDS
+SESSION_TIMEOUT_SECONDS = settings.session_timeout_minutes * 60
+REAP_INTERVAL_SECONDS = 60
+
 # Simple authentication (replace with proper user management in production)
 VALID_CREDENTIALS = {
     "admin": "password123"  # Change this in production!
@@ -33,6 +65,48 @@ VALID_CREDENTIALS = {
 # In-memory storage for track metadata
 tracks_db = {}
 
+# Tombstones for deleted tracks so incremental clients can drop them
+deleted_tracks = {}
+
+# Monotonic change counter used as the track sync cursor. The generation
+# changes on every restart so clients know to discard cursors from a previous run.
+track_change_seq = 0
+SYNC_GENERATION = str(uuid.uuid4())
+
+
+def next_change_seq() -> int:
+    """Return the next value of the track change cursor"""
+    global track_change_seq
+    track_change_seq += 1
+    return track_change_seq
+
+
+def track_summary(track: dict) -> dict:
+    """Public metadata for a track as returned by the listing endpoints"""
+    return {
+        "id": track["id"],
+        "name": track["name"],
+        "filename": track["filename"],
+        "duration": track["duration"],
+        "size": track["size"],
+        "etag": track["etag"],
+        "created_at": track["created_at"].isoformat(),
+        "take": track["take"],
+        "host_start": track["host_start"]
+    }
+
+
+class CompRegion(BaseModel):
+    """A stretch of one take on the host timeline, in samples"""
+    take: int
+    start: int
+    end: int
+
+
+class CompRequest(BaseModel):
+    regions: List[CompRegion]
+    name: Optional[str] = None
+
 
 def verify_credentials(credentials: HTTPBasicCredentials = Depends(security)):
     """Verify HTTP Basic Authentication credentials"""
@@ -58,101 +132,570 @@ def verify_credentials(credentials: HTTPBasicCredentials = Depends(security)):
 
 
 class SessionManager:
-    """Manages recording sessions and chunk assembly"""
+    """Manages recording sessions, their takes and chunk assembly
+
+    A session stays open across any number of takes so the plugin can start
+    and stop recording without a round trip. Each take is assembled into its
+    own track when the session is finalized; chunks carrying a host timeline
+    position keep the take aligned to the DAW timeline, with gaps (e.g. from
+    silence the plugin didn't send) filled back in.
+
+    All chunks of a session live in one append-only data file. An upload
+    reserves a region at the end up front and writes into it with pwrite;
+    regions of rejected uploads are simply never referenced. Reserving and
+    reading or writing raw regions only take the session's data lock, held
+    just long enough to count users of the file descriptor (which is closed
+    once the last of them is done), so uploads never wait behind a finalize
+    or comp holding the session lock. Everything else goes through the
+    session lock and, apart from reserve_chunk, does blocking I/O meant to
+    run in the threadpool.
+
+    Sessions a client abandons (plugin crash, DAW closed mid-take) are
+    reaped once idle for the session timeout: finalized into tracks when
+    auto_finalize_on_timeout is set and they hold audio, otherwise expired
+    with their chunk data deleted. Finalized sessions shrink to what comping
+    needs and are forgotten after the same timeout, and each user can hold
+    only a few open sessions, so memory and chunk storage stay bounded no
+    matter how many sessions are never finished.
+    """
+    # Larger jumps are treated as a relocation rather than a gap to fill
+    MAX_GAP_SECONDS = 600
+
     def __init__(self):
         self.sessions = {}
     
     def create_session(self, username: str) -> str:
-        """Create a new recording session"""
+        """Create a new recording session
+
+        A user already at the open session limit has their least recently
+        used open session closed first, as the reaper would. That can
+        finalize a whole session, so this is blocking and runs in the
+        threadpool.
+        """
+        open_sessions = sorted(
+            (session["last_activity"], session_id)
+            for session_id, session in list(self.sessions.items())
+            if session["username"] == username and not session["completed"]
+        )
+        for _, stale_id in open_sessions[:max(0, len(open_sessions) - settings.max_open_sessions_per_user + 1)]:
+            logger.warning(f"⚠️  User '{username}' has too many open sessions, closing {stale_id[:8]}...")
+            self.close_idle_session(stale_id)
+        
         session_id = str(uuid.uuid4())
         session_path = AUDIO_STORAGE_PATH / f"session_{session_id}"
         session_path.mkdir(exist_ok=True)
+        data_path = session_path / "chunks.dat"
         
         self.sessions[session_id] = {
             "username": username,
             "path": session_path,
-            "chunks": [],
+            "data_path": data_path,
+            "data_fd": os.open(data_path, os.O_RDWR | os.O_CREAT, 0o644),
+            "data_size": 0,
+            "data_users": 0,        # raw reads and writes in progress
+            "data_closing": False,  # the descriptor closes once data_users drops to 0
+            "data_lock": threading.Lock(),
+            "lock": threading.Lock(),
+            "takes": {},
+            "take_tracks": {},
             "created_at": datetime.now(),
+            "last_activity": time.monotonic(),
             "completed": False
         }
         
         logger.info(f"📝 Created new session {session_id[:8]}... for user '{username}'")
         return session_id
     
-    def add_chunk(self, session_id: str, chunk_data: bytes) -> bool:
-        """Add audio chunk to session"""
+    def reserve_chunk(self, session_id: str, length: int) -> Optional[int]:
+        """Reserve length bytes at the end of the session's data file
+
+        Returns the offset to write at, or None if the session is unknown or
+        already finalized. Cheap enough to call from the event loop.
+        """
+        session = self.sessions.get(session_id)
+        if session is None or session["completed"]:
+            return None
+        
+        with session["data_lock"]:
+            if session["data_closing"]:
+                return None
+            offset = session["data_size"]
+            session["data_size"] += length
+        session["last_activity"] = time.monotonic()
+        return offset
+    
+    def write_chunk_data(self, session_id: str, offset: int, data: bytes):
+        """Write part of a reserved region; raises OSError once the session is closed"""
+        with self._data_fd(session_id) as data_fd:
+            os.pwrite(data_fd, data, offset)
+    
+    def read_chunk_data(self, session_id: str, offset: int, length: int) -> bytes:
+        """Read back a region of the session's data file"""
+        with self._data_fd(session_id) as data_fd:
+            return os.pread(data_fd, length, offset)
+    
+    @contextmanager
+    def _data_fd(self, session_id: str):
+        """Borrow the session's data file descriptor; it can't be closed (and its number reused) until the block ends"""
+        session = self.sessions.get(session_id)
+        if session is None:
+            raise OSError(f"Session {session_id[:8]}... is closed")
+        with session["data_lock"]:
+            if session["data_closing"]:
+                raise OSError(f"Session {session_id[:8]}... is closed")
+            session["data_users"] += 1
+        try:
+            yield session["data_fd"]
+        finally:
+            with session["data_lock"]:
+                session["data_users"] -= 1
+                if session["data_closing"] and session["data_users"] == 0:
+                    self._close_data_fd(session)
+    
+    def add_chunk(self, session_id: str, offset: int, length: int, take: int = 0,
+                  position: Optional[int] = None, index: Optional[int] = None,
+                  crc: int = 0) -> bool:
+        """Add a fully written WAV region of the data file to a take of the session
+
+        position is the host timeline sample of the chunk's first frame, if known.
+        index orders chunks within the take so parallel uploads may arrive in any
+        order; chunks without one are taken in arrival order. crc is the CRC-32
+        of the chunk as uploaded, before any decoding.
+        """
         if session_id not in self.sessions:
             logger.warning(f"⚠️  Chunk rejected: session {session_id[:8]}... not found")
             return False
         
         session = self.sessions[session_id]
-        chunk_number = len(session["chunks"])
-        chunk_path = session["path"] / f"chunk_{chunk_number:04d}.wav"
-        
-        with open(chunk_path, "wb") as f:
-            f.write(chunk_data)
+        with session["lock"]:
+            if session["completed"]:
+                logger.warning(f"⚠️  Chunk rejected: session {session_id[:8]}... already finalized")
+                return False
+            
+            take_state = session["takes"].setdefault(take, {
+                "chunks": [],
+                "parked": {},
+                "received": 0,
+                "peaks": PeakBuilder(),
+                "host_start": None,
+                "next_position": None
+            })
+            if index is None:
+                index = take_state["received"]
+            take_state["received"] += 1
+            
+            # A retried upload of a chunk we've already placed is accepted and ignored
+            if index < len(take_state["chunks"]) or index in take_state["parked"]:
+                logger.info(f"🔁 Duplicate take {take} chunk #{index} ignored (session {session_id[:8]}...)")
+                return True
+            
+            take_state["parked"][index] = {"offset": offset, "length": length, "position": position, "crc": crc}
+            self._place_parked_chunks(session, take, take_state)
+            session["last_activity"] = time.monotonic()
         
-        session["chunks"].append(chunk_path)
-        chunk_size_kb = len(chunk_data) / 1024
-        logger.info(f"🎵 Chunk #{chunk_number} received: {chunk_size_kb:.2f} KB (session {session_id[:8]}...)")
+        logger.info(f"🎵 Take {take} chunk #{index} received: {length / 1024:.2f} KB (session {session_id[:8]}...)")
         return True
     
-    def finalize_session(self, session_id: str) -> Optional[str]:
-        """Combine all chunks into final audio file"""
+    def _place_parked_chunks(self, session: dict, take: int, take_state: dict, flush: bool = False):
+        """Append parked chunks that are next in line; flush skips over missing ones"""
+        parked = take_state["parked"]
+        while parked:
+            index = len(take_state["chunks"])
+            if index not in parked:
+                if not flush:
+                    return
+                logger.warning(f"⚠️  Take {take} chunk #{index} never arrived")
+                index = min(parked)
+            
+            chunk = parked.pop(index)
+            take_state["chunks"].append({
+                "offset": chunk["offset"],
+                "length": chunk["length"],
+                "gap": self._measure_chunk(session, take_state, chunk),
+                "crc": chunk["crc"]
+            })
+    
+    def _open_chunk(self, session: dict, chunk: dict):
+        """Open a chunk's region of the data file as a WAV reader"""
+        data = os.pread(session["data_fd"], chunk["length"], chunk["offset"])
+        return wavfile.open(io.BytesIO(data), 'rb')
+    
+    def _measure_chunk(self, session: dict, take_state: dict, chunk: dict) -> int:
+        """Extend the take's timeline and overview with a chunk; returns the gap in front of it"""
+        position = chunk["position"]
+        gap_frames = 0
+        try:
+            with self._open_chunk(session, chunk) as chunk_wav:
+                frame_count = chunk_wav.getnframes()
+                frame_rate = chunk_wav.getframerate()
+                
+                if position is not None:
+                    if take_state["host_start"] is None:
+                        take_state["host_start"] = position
+                    elif take_state["next_position"] is not None:
+                        gap = position - take_state["next_position"]
+                        if 0 < gap <= self.MAX_GAP_SECONDS * frame_rate:
+                            gap_frames = gap
+                    take_state["next_position"] = position + frame_count
+                elif take_state["next_position"] is not None:
+                    take_state["next_position"] += frame_count
+                
+                # Extend the waveform overview now so finalizing doesn't have to rescan the audio
+                take_state["peaks"].add_silence(gap_frames)
+                take_state["peaks"].add_frames(
+                    chunk_wav.readframes(frame_count),
+                    chunk_wav.getnchannels(),
+                    chunk_wav.getsampwidth(),
+                    frame_rate,
+                    chunk_wav.getparams().is_float
+                )
+        except (wavfile.Error, EOFError, ValueError) as e:
+            logger.warning(f"⚠️  No waveform overview for chunk at offset {chunk['offset']}: {e}")
+        
+        return gap_frames
+    
+    def finalize_session(self, session_id: str) -> Optional[List[dict]]:
+        """Assemble every take of the session into its own track
+
+        Returns one {"take", "track_id", "host_start", "chunks", "chunk_hash"}
+        entry per take. chunk_hash is a CRC-32 over the little-endian CRC-32s
+        of the assembled chunks in order, so the client can check the take
+        holds exactly what it sent without downloading it.
+        """
         if session_id not in self.sessions:
             return None
         
         session = self.sessions[session_id]
-        if session["completed"]:
-            return None
+        with session["lock"]:
+            if session["completed"]:
+                return None
+            
+            created = []
+            for take, take_state in sorted(session["takes"].items()):
+                self._place_parked_chunks(session, take, take_state, flush=True)
+                if not take_state["chunks"]:
+                    continue
+                
+                track_id = self._assemble_take(session_id, session, take, take_state)
+                if track_id is not None:
+                    session["take_tracks"][take] = track_id
+                    created.append({
+                        "take": take,
+                        "track_id": track_id,
+                        "host_start": take_state["host_start"],
+                        "chunks": len(take_state["chunks"]),
+                        "chunk_hash": f"{take_chunk_hash(take_state['chunks']):08x}"
+                    })
+            
+            if not created:
+                return None
+            
+            session["completed"] = True
+            session["last_activity"] = time.monotonic()
+            self._release_chunk_data(session)
+            # Comping only needs each take's timeline position
+            session["takes"] = {
+                take: {"host_start": take_state["host_start"]}
+                for take, take_state in session["takes"].items()
+            }
         
-        # Create final audio file path
+        logger.info(f"✅ Session {session_id[:8]}... finalized: {len(created)} take(s)")
+        return created
+    
+    def _assemble_take(self, session_id: str, session: dict, take: int, take_state: dict) -> Optional[str]:
+        """Concatenate a take's chunks, re-inserting timeline gaps as silence"""
         track_id = str(uuid.uuid4())
         final_path = AUDIO_STORAGE_PATH / f"track_{track_id}.wav"
         
-        # Combine all chunks
-        if not session["chunks"]:
-            return None
-        
         try:
             # Open first chunk to get audio parameters
-            with wave.open(str(session["chunks"][0]), 'rb') as first_wav:
+            with self._open_chunk(session, take_state["chunks"][0]) as first_wav:
                 params = first_wav.getparams()
+            
+            frame_bytes = params.nchannels * params.sampwidth
+            silent_frame = (b"\x80" if params.sampwidth == 1 else b"\x00" * params.sampwidth) * params.nchannels
+            
+            with wavfile.open(final_path, 'wb') as output_wav:
+                output_wav.setparams(params)
                 
-                # Create output file
-                with wave.open(str(final_path), 'wb') as output_wav:
-                    output_wav.setparams(params)
-                    
-                    # Write all chunks
-                    for chunk_path in session["chunks"]:
-                        with wave.open(str(chunk_path), 'rb') as chunk_wav:
-                            output_wav.writeframes(chunk_wav.readframes(chunk_wav.getnframes()))
+                for chunk in take_state["chunks"]:
+                    write_silence(output_wav, silent_frame, chunk["gap"])
+                    with self._open_chunk(session, chunk) as chunk_wav:
+                        if not wavfile.same_format(chunk_wav.getparams(), params):
+                            logger.warning(f"⚠️  Take {take} chunk at offset {chunk['offset']} has a different format, skipped")
+                            continue
+                        output_wav.writeframes(chunk_wav.readframes(chunk_wav.getnframes()))
+                
+                total_frames = output_wav.getnframes()
             
-            # Store track metadata
-            tracks_db[track_id] = {
-                "id": track_id,
-                "username": session["username"],
-                "filename": final_path.name,
-                "path": final_path,
-                "created_at": datetime.now(),
-                "session_id": session_id
-            }
+            register_track(
+                track_id, session["username"], final_path, take_state["peaks"].finish(),
+                total_frames, params.framerate,
+                name=f"Take {take} {datetime.now():%Y-%m-%d %H:%M:%S}",
+                session_id=session_id, take=take, host_start=take_state["host_start"]
+            )
             
-            session["completed"] = True
-            total_chunks = len(session["chunks"])
             file_size_mb = final_path.stat().st_size / (1024 * 1024)
-            logger.info(f"✅ Session {session_id[:8]}... finalized: {total_chunks} chunks → {file_size_mb:.2f} MB track")
+            logger.info(f"🎚️  Take {take} of session {session_id[:8]}...: {len(take_state['chunks'])} chunks → {file_size_mb:.2f} MB track")
             return track_id
             
         except Exception as e:
-            logger.error(f"❌ Error finalizing session {session_id[:8]}...: {e}")
+            logger.error(f"❌ Error assembling take {take} of session {session_id[:8]}...: {e}")
+            final_path.unlink(missing_ok=True)
             return None
+    
+    def _release_chunk_data(self, session: dict):
+        """Delete a session's data file once its takes are assembled
+
+        The descriptor closes now, or when the last raw read or write still
+        using it is done.
+        """
+        with session["data_lock"]:
+            session["data_closing"] = True
+            if session["data_users"] == 0:
+                self._close_data_fd(session)
+        session["data_path"].unlink(missing_ok=True)
+        try:
+            session["path"].rmdir()
+        except OSError:
+            pass
+    
+    @staticmethod
+    def _close_data_fd(session: dict):
+        """Under the session's data lock"""
+        if session["data_fd"] is not None:
+            os.close(session["data_fd"])
+            session["data_fd"] = None
+    
+    def close_idle_session(self, session_id: str):
+        """Finalize (if enabled and there is audio) or expire a session, then forget it"""
+        session = self.sessions.get(session_id)
+        if session is None:
+            return
+        
+        if not session["completed"] and settings.auto_finalize_on_timeout:
+            takes = self.finalize_session(session_id)
+            if takes:
+                logger.info(f"⏰ Idle session {session_id[:8]}... auto-finalized into {len(takes)} track(s)")
+        
+        with session["lock"]:
+            if not session["completed"]:
+                session["completed"] = True
+                logger.info(f"🗑️  Idle session {session_id[:8]}... expired")
+            self._release_chunk_data(session)
+        self.sessions.pop(session_id, None)
+    
+    def reap_idle_sessions(self, now: Optional[float] = None) -> int:
+        """Close every session idle for longer than the session timeout
+
+        Returns how many were closed. Blocking; runs in the threadpool.
+        """
+        now = time.monotonic() if now is None else now
+        idle = [
+            session_id for session_id, session in list(self.sessions.items())
+            if now - session["last_activity"] >= SESSION_TIMEOUT_SECONDS
+        ]
+        for session_id in idle:
+            try:
+                self.close_idle_session(session_id)
+            except Exception as e:
+                logger.error(f"❌ Error reaping session {session_id[:8]}...: {e}")
+        return len(idle)
+    
+    def remove_orphaned_sessions(self):
+        """Delete chunk data of sessions from a previous run
+
+        Only directories idle for the session timeout are touched, since
+        other workers sharing the storage may have live sessions.
+        """
+        cutoff = time.time() - SESSION_TIMEOUT_SECONDS
+        for session_path in AUDIO_STORAGE_PATH.glob("session_*"):
+            try:
+                if not session_path.is_dir() or session_path.stat().st_mtime >= cutoff:
+                    continue
+                if any(path.stat().st_mtime >= cutoff for path in session_path.iterdir()):
+                    continue
+                for path in session_path.iterdir():
+                    path.unlink()
+                session_path.rmdir()
+                logger.info(f"🧹 Removed orphaned {session_path.name}")
+            except OSError as e:
+                logger.warning(f"⚠️  Could not remove orphaned {session_path.name}: {e}")
+    
+    def comp_session(self, session_id: str, regions: List[CompRegion], name: Optional[str] = None) -> str:
+        """Render a comp track from host-timeline regions of a finalized session's takes
+
+        Regions are applied in timeline order; where two overlap the earlier one
+        wins. Raises KeyError if the session is gone and ValueError when the
+        regions can't be rendered. Blocking; runs in the threadpool.
+        """
+        session = self.sessions.get(session_id)
+        if session is None:
+            raise KeyError(session_id)
+        
+        # Held for the whole render so the reaper can't close the session under it
+        with session["lock"]:
+            if not session["completed"]:
+                raise ValueError("Session must be finalized before comping")
+            if not regions:
+                raise ValueError("No regions given")
+            
+            ordered = sorted(regions, key=lambda region: region.start)
+            sources = {}
+            for region in ordered:
+                if region.end <= region.start:
+                    raise ValueError(f"Empty region for take {region.take}")
+                track_id = session["take_tracks"].get(region.take)
+                if track_id is None or track_id not in tracks_db:
+                    raise ValueError(f"Take {region.take} has no track")
+                if session["takes"][region.take]["host_start"] is None:
+                    raise ValueError(f"Take {region.take} has no timeline position")
+                sources[region.take] = tracks_db[track_id]
+            
+            track_id = str(uuid.uuid4())
+            final_path = AUDIO_STORAGE_PATH / f"track_{track_id}.wav"
+            peaks = PeakBuilder()
+            params = None
+            
+            try:
+                with wavfile.open(final_path, 'wb') as output_wav:
+                    timeline_start = ordered[0].start
+                    cursor = timeline_start
+                    
+                    for region in ordered:
+                        start = max(region.start, cursor)
+                        if start >= region.end:
+                            continue
+                        
+                        with wavfile.open(sources[region.take]["path"], 'rb') as take_wav:
+                            take_params = take_wav.getparams()
+                            if params is None:
+                                params = take_params
+                                output_wav.setparams(params)
+                                peaks.set_format(params.nchannels, params.sampwidth, params.framerate, params.is_float)
+                            elif not wavfile.same_format(take_params, params):
+                                raise ValueError(f"Take {region.take} has a different audio format")
+                            
+                            silent_frame = (b"\x80" if params.sampwidth == 1 else b"\x00" * params.sampwidth) * params.nchannels
+                            write_silence(output_wav, silent_frame, start - cursor, peaks)
+                            
+                            # Map the region onto the take, padding anything outside what was recorded
+                            host_start = session["takes"][region.take]["host_start"]
+                            first = start - host_start
+                            last = region.end - host_start
+                            available_first = min(max(first, 0), take_params.nframes)
+                            available_last = min(max(last, 0), take_params.nframes)
+                            
+                            # A region entirely before the take is all lead-in, and only as long as itself
+                            write_silence(output_wav, silent_frame, min(available_first, last) - first, peaks)
+                            take_wav.setpos(available_first)
+                            frames = take_wav.readframes(available_last - available_first)
+                            output_wav.writeframes(frames)
+                            peaks.add_frames(frames, params.nchannels, params.sampwidth, params.framerate, params.is_float)
+                            write_silence(output_wav, silent_frame, last - max(available_last, first), peaks)
+                        
+                        cursor = region.end
+                    
+                    total_frames = output_wav.getnframes()
+                
+                register_track(
+                    track_id, session["username"], final_path, peaks.finish(),
+                    total_frames, params.framerate,
+                    name=name or f"Comp {datetime.now():%Y-%m-%d %H:%M:%S}",
+                    session_id=session_id, take=None, host_start=timeline_start
+                )
+            except Exception:
+                final_path.unlink(missing_ok=True)
+                raise
+            
+            session["last_activity"] = time.monotonic()
+        logger.info(f"✂️  Comp of session {session_id[:8]}... rendered from {len(ordered)} region(s)")
+        return track_id
+
+
+def take_chunk_hash(chunks: List[dict]) -> int:
+    """CRC-32 over the per-chunk CRC-32s, in assembly order"""
+    return zlib.crc32(b"".join(struct.pack("<I", chunk["crc"]) for chunk in chunks))
+
+
+def decode_chunk(chunk_data: bytes) -> bytes:
+    """Turn an uploaded chunk into 16-bit PCM WAV bytes
+
+    Bandwidth-constrained clients send each chunk as a self-contained Ogg
+    Vorbis stream; it is decoded once on receipt so assembly, peaks and
+    comping only ever deal with PCM. WAV chunks pass through untouched.
+    """
+    if not chunk_data.startswith(b"OggS"):
+        return chunk_data
+    
+    samples, sample_rate = soundfile.read(io.BytesIO(chunk_data), dtype="int16", always_2d=True)
+    
+    output = io.BytesIO()
+    with wavfile.open(output, 'wb') as chunk_wav:
+        chunk_wav.setparams(wavfile.WavParams(samples.shape[1], 2, sample_rate, 0, False))
+        chunk_wav.writeframes(samples.astype("<i2").tobytes())
+    return output.getvalue()
+
+
+def write_silence(output_wav, silent_frame: bytes, frame_count: int, peaks: Optional[PeakBuilder] = None):
+    """Append frame_count silent frames in bounded pieces"""
+    if frame_count <= 0:
+        return
+    
+    if peaks is not None:
+        peaks.add_silence(frame_count)
+    
+    block = silent_frame * 65536
+    while frame_count > 0:
+        frames = min(frame_count, 65536)
+        output_wav.writeframes(block[:frames * len(silent_frame)])
+        frame_count -= frames
+
+
+def register_track(track_id: str, username: str, path: Path, peaks_data: bytes,
+                   total_frames: int, frame_rate: int, name: str,
+                   session_id: str, take: Optional[int], host_start: Optional[int]):
+    """Store peaks and metadata for a freshly written track file"""
+    peaks_path = AUDIO_STORAGE_PATH / f"track_{track_id}.peaks"
+    peaks_path.write_bytes(peaks_data)
+    
+    # Tracks never change after assembly, so size and mtime are enough to
+    # identify the exact bytes for client-side caches.
+    file_stat = path.stat()
+    tracks_db[track_id] = {
+        "id": track_id,
+        "username": username,
+        "name": name,
+        "filename": path.name,
+        "path": path,
+        "peaks_path": peaks_path,
+        "duration": total_frames / frame_rate if frame_rate else 0.0,
+        "size": file_stat.st_size,
+        "etag": f"{file_stat.st_size:x}-{file_stat.st_mtime_ns:x}",
+        "created_at": datetime.now(),
+        "session_id": session_id,
+        "take": take,
+        "host_start": host_start,
+        "seq": next_change_seq()
+    }
 
 
 # Global session manager
 session_manager = SessionManager()
 
 
+async def reap_idle_sessions_periodically():
+    """Background task closing sessions their clients abandoned"""
+    while True:
+        await asyncio.sleep(REAP_INTERVAL_SECONDS)
+        try:
+            reaped = await run_in_threadpool(session_manager.reap_idle_sessions)
+            if reaped:
+                logger.info(f"⏰ Reaped {reaped} idle session(s), {len(session_manager.sessions)} remaining")
+        except Exception as e:
+            logger.error(f"❌ Session reaper failed: {e}")
+
+
 @app.get("/")
 async def root():
     """API root endpoint"""
@@ -167,31 +710,146 @@ async def root():
 async def start_session(username: str = Depends(verify_credentials)):
     """Start a new recording session"""
     logger.info(f"🎙️  User '{username}' starting new recording session")
-    session_id = session_manager.create_session(username)
+    session_id = await run_in_threadpool(session_manager.create_session, username)
     return {
         "session_id": session_id,
         "message": "Recording session started"
     }
 
 
+async def read_upload_pieces(request: Request):
+    """Yield the uploaded chunk in pieces of at most INGEST_PIECE_BYTES, and its declared size
+
+    Raw bodies (audio/wav, audio/ogg, application/octet-stream) are streamed
+    straight off the socket. Multipart uploads from older clients are parsed
+    by Starlette, which spools the file part to disk past 1 MB.
+    """
+    content_type = request.headers.get("content-type", "")
+    
+    if content_type.startswith("multipart/form-data"):
+        form = await request.form()
+        upload = form.get("file")
+        if upload is None or isinstance(upload, str):
+            raise HTTPException(status_code=400, detail="Missing file field")
+        
+        async def form_pieces():
+            while piece := await upload.read(INGEST_PIECE_BYTES):
+                yield piece
+        
+        return form_pieces(), upload.size
+    
+    length = request.headers.get("content-length")
+    if length is None or not length.isdigit():
+        raise HTTPException(status_code=411, detail="Content-Length required")
+    
+    async def body_pieces():
+        # Socket reads can be tiny; gather them so each disk write is worthwhile
+        pending = bytearray()
+        async for data in request.stream():
+            pending += data
+            while len(pending) >= INGEST_PIECE_BYTES:
+                yield bytes(pending[:INGEST_PIECE_BYTES])
+                del pending[:INGEST_PIECE_BYTES]
+        if pending:
+            yield bytes(pending)
+    
+    return body_pieces(), int(length)
+
+
+async def write_chunk_region(session_id: str, pieces, length: int) -> tuple:
+    """Stream pieces into a freshly reserved region of the session's data file
+
+    Returns (offset, crc). Disk writes run in the threadpool so the event loop
+    keeps serving other uploads meanwhile.
+    """
+    offset = session_manager.reserve_chunk(session_id, length)
+    if offset is None:
+        raise HTTPException(status_code=404, detail="Session not found")
+    
+    crc = 0
+    written = 0
+    try:
+        async for piece in pieces:
+            if written + len(piece) > length:
+                raise HTTPException(status_code=400, detail="Chunk larger than declared")
+            await run_in_threadpool(session_manager.write_chunk_data, session_id, offset + written, piece)
+            crc = zlib.crc32(piece, crc)
+            written += len(piece)
+    except OSError:
+        raise HTTPException(status_code=409, detail="Session was closed during upload")
+    
+    if written != length:
+        raise HTTPException(status_code=400, detail="Incomplete chunk")
+    return offset, crc
+
+
 @app.post("/api/upload-chunk")
 async def upload_chunk(
-    file: UploadFile = File(...),
+    request: Request,
     session_id: Optional[str] = None,
+    take: int = 0,
+    position: Optional[int] = None,
+    index: Optional[int] = None,
+    x_chunk_crc32: Optional[str] = Header(None),
     username: str = Depends(verify_credentials)
 ):
-    """Receive audio chunk from plugin"""
+    """Receive audio chunk from plugin
+
+    The chunk is either the raw request body or the "file" field of a
+    multipart form. take groups chunks within the session; position is the
+    host timeline sample of the chunk's first frame when the host was
+    playing. index is the chunk's place within the take, for uploads sent in
+    parallel. The optional X-Chunk-CRC32 header (hex) is checked against the
+    body; a chunk that fails it leaves an unused region behind in the
+    session's data file and is never assembled.
+    """
     # Create session if not provided
     if session_id is None:
         logger.info(f"📝 Auto-creating session for user '{username}'")
-        session_id = session_manager.create_session(username)
+        session_id = await run_in_threadpool(session_manager.create_session, username)
+    
+    expected_crc = None
+    if x_chunk_crc32 is not None:
+        try:
+            expected_crc = int(x_chunk_crc32, 16)
+        except ValueError:
+            raise HTTPException(status_code=400, detail="Malformed X-Chunk-CRC32 header")
+    
+    pieces, length = await read_upload_pieces(request)
+    if length is None or length <= 0:
+        raise HTTPException(status_code=400, detail="Empty chunk")
+    if length > MAX_CHUNK_BYTES:
+        raise HTTPException(status_code=413, detail="Chunk too large")
+    
+    logger.debug(f"📥 Receiving chunk from '{username}': {length} bytes")
+    offset, crc = await write_chunk_region(session_id, pieces, length)
     
-    # Read chunk data
-    chunk_data = await file.read()
-    logger.debug(f"📥 Receiving chunk from '{username}': {len(chunk_data)} bytes")
+    if expected_crc is not None and expected_crc != crc:
+        logger.error(f"❌ Checksum mismatch on take {take} chunk #{index} (session {session_id[:8]}...)")
+        raise HTTPException(status_code=400, detail="Chunk checksum mismatch")
+    
+    # Lossy chunks are decoded once here and stored as PCM next to the original
+    pcm_offset, pcm_length = offset, length
+    try:
+        head = await run_in_threadpool(session_manager.read_chunk_data, session_id, offset, 4)
+        if head == b"OggS":
+            chunk_data = await run_in_threadpool(session_manager.read_chunk_data, session_id, offset, length)
+            pcm_data = await run_in_threadpool(decode_chunk, chunk_data)
+            pcm_length = len(pcm_data)
+            pcm_offset = session_manager.reserve_chunk(session_id, pcm_length)
+            if pcm_offset is None:
+                raise HTTPException(status_code=404, detail="Session not found")
+            await run_in_threadpool(session_manager.write_chunk_data, session_id, pcm_offset, pcm_data)
+    except (RuntimeError, ValueError) as e:
+        logger.error(f"❌ Undecodable chunk for session {session_id[:8]}...: {e}")
+        raise HTTPException(status_code=400, detail="Chunk could not be decoded")
+    except OSError:
+        raise HTTPException(status_code=409, detail="Session was closed during upload")
     
     # Add chunk to session
-    success = session_manager.add_chunk(session_id, chunk_data)
+    success = await run_in_threadpool(
+        session_manager.add_chunk, session_id, pcm_offset, pcm_length, take, position, index, crc
+    )
     
     if not success:
         logger.error(f"❌ Failed to add chunk to session {session_id[:8]}...")
@@ -200,7 +858,7 @@ async def upload_chunk(
     return {
         "message": "Chunk received",
         "session_id": session_id,
-        "chunk_size": len(chunk_data)
+        "chunk_size": length
     }
 
 
@@ -209,16 +867,46 @@ async def finalize_session(
     session_id: str,
     username: str = Depends(verify_credentials)
 ):
-    """Finalize recording session and create complete track"""
-    track_id = session_manager.finalize_session(session_id)
+    """Finalize recording session and create one track per take"""
+    takes = await run_in_threadpool(session_manager.finalize_session, session_id)
     
-    if track_id is None:
+    if takes is None:
         raise HTTPException(status_code=404, detail="Session not found or already completed")
     
-    logger.info(f"✅ Session {session_id[:8]}... finalized, created track: {track_id[:8]}...")
+    logger.info(f"✅ Session {session_id[:8]}... finalized, created {len(takes)} track(s)")
     
     return {
         "message": "Session finalized",
+        "track_id": takes[0]["track_id"],
+        "takes": takes
+    }
+
+
+@app.post("/api/sessions/{session_id}/comp")
+async def comp_session(
+    session_id: str,
+    request: CompRequest,
+    username: str = Depends(verify_credentials)
+):
+    """Render a comp track from regions of a finalized session's takes"""
+    session = session_manager.sessions.get(session_id)
+    if session is None:
+        raise HTTPException(status_code=404, detail="Session not found")
+    
+    # Verify user owns this session
+    if session["username"] != username:
+        raise HTTPException(status_code=403, detail="Access denied")
+    
+    # Rendering reads and writes whole takes, so it stays off the event loop
+    try:
+        track_id = await run_in_threadpool(session_manager.comp_session, session_id, request.regions, request.name)
+    except KeyError:
+        raise HTTPException(status_code=404, detail="Session not found")
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    
+    return {
+        "message": "Comp rendered",
         "track_id": track_id
     }
 
@@ -227,11 +915,7 @@ async def finalize_session(
 async def list_tracks(username: str = Depends(verify_credentials)):
     """List all recorded tracks for authenticated user"""
     user_tracks = [
-        {
-            "id": track["id"],
-            "filename": track["filename"],
-            "created_at": track["created_at"].isoformat()
-        }
+        track_summary(track)
         for track in tracks_db.values()
         if track["username"] == username
     ]
@@ -239,10 +923,46 @@ async def list_tracks(username: str = Depends(verify_credentials)):
     return user_tracks
 
 
+@app.get("/api/tracks/changes")
+async def list_track_changes(
+    since: int = 0,
+    limit: int = 200,
+    username: str = Depends(verify_credentials)
+):
+    """List tracks added or deleted after the given cursor, oldest change first"""
+    limit = max(1, min(limit, 1000))
+    
+    changes = [
+        (track["seq"], track_summary(track), None)
+        for track in tracks_db.values()
+        if track["username"] == username and track["seq"] > since
+    ]
+    changes.extend(
+        (tombstone["seq"], None, track_id)
+        for track_id, tombstone in deleted_tracks.items()
+        if tombstone["username"] == username and tombstone["seq"] > since
+    )
+    changes.sort(key=lambda change: change[0])
+    
+    page = changes[:limit]
+    has_more = len(changes) > limit
+    # An empty page still advances to the current cursor so idle clients stop rescanning
+    cursor = page[-1][0] if page else track_change_seq
+    
+    return {
+        "generation": SYNC_GENERATION,
+        "tracks": [summary for _, summary, _ in page if summary is not None],
+        "deleted": [track_id for _, _, track_id in page if track_id is not None],
+        "cursor": cursor,
+        "has_more": has_more
+    }
+
+
 @app.get("/api/download/{track_id}")
 async def download_track(
     track_id: str,
-    username: str = Depends(verify_credentials)
+    username: str = Depends(verify_credentials),
+    if_none_match: Optional[str] = Header(None)
 ):
     """Download a recorded track"""
     if track_id not in tracks_db:
@@ -254,11 +974,38 @@ async def download_track(
     if track["username"] != username:
         raise HTTPException(status_code=403, detail="Access denied")
     
+    etag = f'"{track["etag"]}"'
+    if if_none_match == etag:
+        return Response(status_code=304, headers={"ETag": etag})
+    
     logger.info(f"⬇️  User '{username}' downloading track {track_id[:8]}... ({track['filename']})")
     return FileResponse(
         path=track["path"],
         media_type="audio/wav",
-        filename=track["filename"]
+        filename=track["filename"],
+        headers={"ETag": etag}
+    )
+
+
+@app.get("/api/tracks/{track_id}/peaks")
+async def download_track_peaks(
+    track_id: str,
+    username: str = Depends(verify_credentials)
+):
+    """Download the binary min/max waveform overview of a track (see peaks.py)"""
+    if track_id not in tracks_db:
+        raise HTTPException(status_code=404, detail="Track not found")
+    
+    track = tracks_db[track_id]
+    
+    # Verify user owns this track
+    if track["username"] != username:
+        raise HTTPException(status_code=403, detail="Access denied")
+    
+    return FileResponse(
+        path=track["peaks_path"],
+        media_type="application/octet-stream",
+        headers={"ETag": f'"{track["etag"]}"'}
     )
 
 
@@ -280,7 +1027,9 @@ async def delete_track(
     # Delete file
     try:
         os.remove(track["path"])
+        track["peaks_path"].unlink(missing_ok=True)
         del tracks_db[track_id]
+        deleted_tracks[track_id] = {"username": username, "seq": next_change_seq()}
         return {"message": "Track deleted successfully"}
     except Exception as e:
         raise HTTPException(status_code=500, detail=f"Error deleting track: {str(e)}")
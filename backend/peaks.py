@@ -0,0 +1,159 @@
+"""
+Multi-resolution min/max waveform overviews ("peak pyramids")
+
+Level 0 holds one min/max pair per BASE_BUCKET_FRAMES frames; every level
+above combines LEVEL_FACTOR buckets of the one below. A client picks the
+level closest to its pixels-per-frame ratio and touches at most a handful of
+buckets per pixel, whatever the track length.
+
+Binary layout (little-endian):
+    header: magic "AXPK", u16 version, u16 level count, u32 sample rate,
+            u64 total frames, u32 base bucket frames, u32 level factor
+    per level: u32 bucket count, then count x (i8 min, i8 max)
+"""
+import math
+import struct
+import sys
+from array import array
+from typing import Callable, Tuple
+
+MAGIC = b"AXPK"
+VERSION = 1
+BASE_BUCKET_FRAMES = 256
+LEVEL_FACTOR = 4
+
+HEADER_FORMAT = "<4sHHIQII"
+
+
+class PeakBuilder:
+    """Builds a peak pyramid incrementally as PCM frames arrive"""
+
+    def __init__(self):
+        self.sample_rate = 0
+        self.channels = 0
+        self.sample_width = 0
+        self.is_float = False
+        self.total_frames = 0
+        self.mins = array("b")
+        self.maxs = array("b")
+        self.pending = b""
+
+    def set_format(self, channels: int, sample_width: int, sample_rate: int, is_float: bool = False):
+        """Fix the PCM format; the first call wins"""
+        if self.channels == 0:
+            self.channels = channels
+            self.sample_width = sample_width
+            self.sample_rate = sample_rate
+            self.is_float = is_float
+
+    def add_frames(self, frames: bytes, channels: int, sample_width: int, sample_rate: int,
+                   is_float: bool = False):
+        """Feed interleaved PCM frames; partial buckets carry over to the next call"""
+        self.set_format(channels, sample_width, sample_rate, is_float)
+
+        frame_bytes = self.channels * self.sample_width
+        self.total_frames += len(frames) // frame_bytes
+
+        data = self.pending + frames
+        bucket_bytes = BASE_BUCKET_FRAMES * frame_bytes
+        whole = len(data) - len(data) % bucket_bytes
+        self.pending = data[whole:]
+        self._add_buckets(data[:whole])
+
+    def add_silence(self, frame_count: int):
+        """Extend the overview by frame_count silent frames without materialising them"""
+        if frame_count <= 0 or self.channels == 0:
+            return
+
+        frame_bytes = self.channels * self.sample_width
+        silent_frame = (b"\x80" if self.sample_width == 1 else b"\x00" * self.sample_width) * self.channels
+
+        # Top up the partial bucket with real silent frames, then append whole zero buckets directly
+        pending_frames = len(self.pending) // frame_bytes
+        if pending_frames:
+            fill = min(frame_count, BASE_BUCKET_FRAMES - pending_frames)
+            self.add_frames(silent_frame * fill, self.channels, self.sample_width, self.sample_rate, self.is_float)
+            frame_count -= fill
+
+        whole_buckets = frame_count // BASE_BUCKET_FRAMES
+        self.mins.extend(bytes(whole_buckets))
+        self.maxs.extend(bytes(whole_buckets))
+        self.total_frames += whole_buckets * BASE_BUCKET_FRAMES
+
+        remainder = frame_count - whole_buckets * BASE_BUCKET_FRAMES
+        if remainder:
+            self.add_frames(silent_frame * remainder, self.channels, self.sample_width, self.sample_rate, self.is_float)
+
+    def finish(self) -> bytes:
+        """Flush the last partial bucket and serialize every level"""
+        frame_bytes = max(1, self.channels * self.sample_width)
+        tail = self.pending[:len(self.pending) - len(self.pending) % frame_bytes]
+        self.pending = b""
+        self._add_buckets(tail)
+
+        levels = [(self.mins, self.maxs)]
+        while len(levels[-1][0]) > 1:
+            levels.append(_downsample(*levels[-1]))
+
+        out = bytearray(struct.pack(
+            HEADER_FORMAT, MAGIC, VERSION, len(levels), self.sample_rate,
+            self.total_frames, BASE_BUCKET_FRAMES, LEVEL_FACTOR
+        ))
+        for mins, maxs in levels:
+            pairs = array("b", bytes(2 * len(mins)))
+            pairs[0::2] = mins
+            pairs[1::2] = maxs
+            out += struct.pack("<I", len(mins))
+            out += pairs.tobytes()
+        return bytes(out)
+
+    def _add_buckets(self, data: bytes):
+        if not data:
+            return
+
+        samples, to_int8 = _decode(data, self.sample_width, self.is_float)
+        bucket_samples = BASE_BUCKET_FRAMES * self.channels
+        # Channels are folded together; the overview shows the loudest of them.
+        # min/max run over native arrays so the per-sample work stays in C.
+        for start in range(0, len(samples), bucket_samples):
+            bucket = samples[start:start + bucket_samples]
+            self.mins.append(to_int8(min(bucket)))
+            self.maxs.append(to_int8(max(bucket)))
+
+
+def _decode(data: bytes, sample_width: int, is_float: bool = False) -> Tuple[array, Callable]:
+    """Wrap PCM bytes in a typed array; returns (samples, scaling of one sample to int8)"""
+    if is_float:
+        if sample_width != 4:
+            raise ValueError(f"Unsupported float sample width: {sample_width}")
+        samples = _native_array("f", data)
+        return samples, lambda value: max(-128, min(127, math.floor(value * 128.0))) if value == value else 0
+    if sample_width == 1:
+        # 8-bit WAV is unsigned
+        return array("B", data), lambda value: value - 128
+    if sample_width == 2:
+        return _native_array("h", data), lambda value: value >> 8
+    if sample_width == 3:
+        # Only the most significant byte of each little-endian sample matters at int8 resolution
+        return array("b", data[2::3]), lambda value: value
+    if sample_width == 4:
+        return _native_array("i", data), lambda value: value >> 24
+    raise ValueError(f"Unsupported sample width: {sample_width}")
+
+
+def _native_array(typecode: str, data: bytes) -> array:
+    """Little-endian bytes as a typed array in native byte order"""
+    samples = array(typecode)
+    samples.frombytes(data)
+    if sys.byteorder == "big":
+        samples.byteswap()
+    return samples
+
+
+def _downsample(mins: array, maxs: array) -> Tuple[array, array]:
+    next_mins = array("b")
+    next_maxs = array("b")
+    for start in range(0, len(mins), LEVEL_FACTOR):
+        next_mins.append(min(mins[start:start + LEVEL_FACTOR]))
+        next_maxs.append(max(maxs[start:start + LEVEL_FACTOR]))
+    return next_mins, next_maxs
@@ -0,0 +1,71 @@
+"""
+Shared fixtures for the backend tests
+
+The app keeps its storage under ./audio_storage, so the tests run from a
+scratch directory and never touch a real one.
+"""
+import io
+import os
+import struct
+import sys
+import tempfile
+import wave
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent))
+os.chdir(tempfile.mkdtemp(prefix="auxlee-tests-"))
+
+from fastapi.testclient import TestClient  # noqa: E402
+
+import main  # noqa: E402
+
+AUTH = ("admin", "password123")
+
+
+@pytest.fixture
+def client():
+    with TestClient(main.app) as test_client:
+        yield test_client
+    
+    for session_id in list(main.session_manager.sessions):
+        main.session_manager.close_idle_session(session_id)
+    main.tracks_db.clear()
+
+
+def make_chunk(frames: int, value: int, channels: int = 2, rate: int = 44100) -> bytes:
+    """A 16-bit WAV chunk whose every sample is value, so its place in a track is easy to spot"""
+    buffer = io.BytesIO()
+    with wave.open(buffer, "wb") as chunk_wav:
+        chunk_wav.setnchannels(channels)
+        chunk_wav.setsampwidth(2)
+        chunk_wav.setframerate(rate)
+        chunk_wav.writeframes(value.to_bytes(2, "little", signed=True) * channels * frames)
+    return buffer.getvalue()
+
+
+def read_track_samples(track_id: str) -> list:
+    """First-channel sample of every frame of an assembled track"""
+    with main.wavfile.open(main.tracks_db[track_id]["path"], "rb") as track_wav:
+        frames = track_wav.readframes(track_wav.getnframes())
+        channels = track_wav.getnchannels()
+    return [value for (value,) in struct.iter_unpack("<h", frames)][::channels]
+
+
+def start_session(client) -> str:
+    response = client.post("/api/start-session", auth=AUTH)
+    assert response.status_code == 200
+    return response.json()["session_id"]
+
+
+def upload(client, session_id: str, data: bytes, take: int = 0, index=None, position=None, crc=None):
+    params = {"session_id": session_id, "take": take}
+    if index is not None:
+        params["index"] = index
+    if position is not None:
+        params["position"] = position
+    headers = {"Content-Type": "audio/wav"}
+    if crc is not None:
+        headers["X-Chunk-CRC32"] = f"{crc:08x}"
+    return client.post("/api/upload-chunk", params=params, content=data, headers=headers, auth=AUTH)
@@ -0,0 +1,89 @@
+"""
+Sustained load on one worker: many sessions uploading at once, and uploads
+that keep going while another session of the same user is being assembled
+"""
+import random
+import threading
+import time
+
+import main
+from conftest import AUTH, make_chunk, read_track_samples, start_session, upload
+
+SESSIONS = 6
+CHUNKS_PER_SESSION = 40
+UPLOADERS_PER_SESSION = 3
+FRAMES_PER_CHUNK = 441
+
+
+def test_concurrent_sessions_sustain_parallel_uploads(client):
+    session_ids = [start_session(client) for _ in range(SESSIONS)]
+    failures = []
+    
+    def upload_chunks(session_number: int, session_id: str, indices: list):
+        for index in indices:
+            response = upload(client, session_id, make_chunk(FRAMES_PER_CHUNK, session_number * 100 + index), index=index)
+            if response.status_code != 200:
+                failures.append((session_id, index, response.status_code))
+    
+    # Each session's chunks arrive shuffled over several connections, like a bounce
+    uploaders = []
+    for session_number, session_id in enumerate(session_ids):
+        indices = list(range(CHUNKS_PER_SESSION))
+        random.Random(session_number).shuffle(indices)
+        for part in range(UPLOADERS_PER_SESSION):
+            uploaders.append(threading.Thread(
+                target=upload_chunks,
+                args=(session_number, session_id, indices[part::UPLOADERS_PER_SESSION])
+            ))
+    
+    started = time.monotonic()
+    for uploader in uploaders:
+        uploader.start()
+    for uploader in uploaders:
+        uploader.join(timeout=60)
+    elapsed = time.monotonic() - started
+    
+    assert not any(uploader.is_alive() for uploader in uploaders)
+    assert failures == []
+    print(f"{SESSIONS * CHUNKS_PER_SESSION} chunks over {len(uploaders)} connections in {elapsed:.2f} s")
+    
+    for session_number, session_id in enumerate(session_ids):
+        response = client.post("/api/finalize-session", params={"session_id": session_id}, auth=AUTH)
+        assert response.status_code == 200
+        take = response.json()["takes"][0]
+        assert take["chunks"] == CHUNKS_PER_SESSION
+        
+        expected = []
+        for index in range(CHUNKS_PER_SESSION):
+            expected += [session_number * 100 + index] * FRAMES_PER_CHUNK
+        assert read_track_samples(take["track_id"]) == expected
+
+
+def test_chunk_writes_dont_wait_behind_the_session_lock(client):
+    session_id = start_session(client)
+    session = main.session_manager.sessions[session_id]
+    chunk = make_chunk(100, 1)
+    offset = main.session_manager.reserve_chunk(session_id, len(chunk))
+    
+    # A finalize or comp holds the session lock for the whole assembly
+    with session["lock"]:
+        writer = threading.Thread(target=main.session_manager.write_chunk_data, args=(session_id, offset, chunk))
+        writer.start()
+        writer.join(timeout=2)
+        assert not writer.is_alive(), "piece write waited for the session lock"
+    
+    assert main.session_manager.read_chunk_data(session_id, offset, len(chunk)) == chunk
+
+
+def test_data_file_closes_after_the_last_write_using_it(client):
+    session_id = start_session(client)
+    assert upload(client, session_id, make_chunk(100, 1), index=0).status_code == 200
+    session = main.session_manager.sessions[session_id]
+    
+    with main.session_manager._data_fd(session_id) as data_fd:
+        assert client.post("/api/finalize-session", params={"session_id": session_id}, auth=AUTH).status_code == 200
+        # Finalized, but a write still in progress keeps the descriptor open
+        assert session["data_fd"] == data_fd
+        assert main.session_manager.reserve_chunk(session_id, 10) is None
+    
+    assert session["data_fd"] is None
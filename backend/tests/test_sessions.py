@@ -0,0 +1,133 @@
+"""
+Session lifetime: the idle reaper finalizing or expiring abandoned sessions,
+the per-user cap on open sessions, and comping a finalized session
+"""
+import os
+import time
+
+import pytest
+
+import main
+from conftest import AUTH, make_chunk, read_track_samples, start_session, upload
+
+
+def reap_after_timeout() -> int:
+    return main.session_manager.reap_idle_sessions(now=time.monotonic() + main.SESSION_TIMEOUT_SECONDS + 1)
+
+
+def test_reaper_auto_finalizes_idle_session_with_audio(client, monkeypatch):
+    monkeypatch.setattr(main.settings, "auto_finalize_on_timeout", True)
+    session_id = start_session(client)
+    session_path = main.session_manager.sessions[session_id]["path"]
+    
+    assert upload(client, session_id, make_chunk(100, 3), index=0).status_code == 200
+    assert reap_after_timeout() == 1
+    
+    assert session_id not in main.session_manager.sessions
+    assert not session_path.exists()
+    assert len(main.tracks_db) == 1
+    
+    # The client's next upload learns the session is gone
+    assert upload(client, session_id, make_chunk(100, 3), index=1).status_code == 404
+
+
+def test_reaper_expires_idle_session_without_finalizing_when_disabled(client, monkeypatch):
+    monkeypatch.setattr(main.settings, "auto_finalize_on_timeout", False)
+    session_id = start_session(client)
+    session_path = main.session_manager.sessions[session_id]["path"]
+    
+    assert upload(client, session_id, make_chunk(100, 3), index=0).status_code == 200
+    assert reap_after_timeout() == 1
+    
+    assert session_id not in main.session_manager.sessions
+    assert not session_path.exists()
+    assert main.tracks_db == {}
+
+
+def test_reaper_expires_idle_session_without_audio(client):
+    session_id = start_session(client)
+    
+    assert reap_after_timeout() == 1
+    assert session_id not in main.session_manager.sessions
+    assert main.tracks_db == {}
+
+
+def test_reaper_leaves_active_sessions_alone(client):
+    session_id = start_session(client)
+    
+    assert main.session_manager.reap_idle_sessions() == 0
+    assert session_id in main.session_manager.sessions
+
+
+def test_open_session_cap_closes_least_recently_used(client, monkeypatch):
+    monkeypatch.setattr(main.settings, "max_open_sessions_per_user", 3)
+    monkeypatch.setattr(main.settings, "auto_finalize_on_timeout", True)
+    
+    oldest = start_session(client)
+    assert upload(client, oldest, make_chunk(100, 1), index=0).status_code == 200
+    others = [start_session(client) for _ in range(2)]
+    
+    # Touching a session makes it recent, so the cap takes the next oldest
+    assert upload(client, oldest, make_chunk(100, 1), index=1).status_code == 200
+    newest = start_session(client)
+    
+    open_sessions = set(main.session_manager.sessions)
+    assert open_sessions == {oldest, others[1], newest}
+    assert main.tracks_db == {}
+    
+    # An evicted session holding audio is auto-finalized like a reaped one
+    start_session(client)
+    assert others[1] not in main.session_manager.sessions
+    assert main.tracks_db == {}
+    start_session(client)
+    assert oldest not in main.session_manager.sessions
+    assert len(main.tracks_db) == 1
+    assert len(main.session_manager.sessions) == 3
+
+
+def test_comp_region_before_the_take_is_only_as_long_as_itself(client):
+    session_id = start_session(client)
+    assert upload(client, session_id, make_chunk(100, 1), index=0, position=1000).status_code == 200
+    assert client.post("/api/finalize-session", params={"session_id": session_id}, auth=AUTH).status_code == 200
+    
+    # 10 frames entirely before the take, a 10 frame gap, then the take itself
+    regions = [
+        {"take": 0, "start": 980, "end": 990},
+        {"take": 0, "start": 1000, "end": 1100},
+    ]
+    response = client.post(f"/api/sessions/{session_id}/comp", json={"regions": regions}, auth=AUTH)
+    assert response.status_code == 200
+    
+    track_id = response.json()["track_id"]
+    assert main.tracks_db[track_id]["host_start"] == 980
+    assert read_track_samples(track_id) == [0] * 20 + [1] * 100
+
+
+def open_descriptor_count() -> int:
+    return len(os.listdir("/proc/self/fd"))
+
+
+@pytest.mark.parametrize("auto_finalize", [False, True])
+def test_many_abandoned_sessions_leave_nothing_behind(client, monkeypatch, auto_finalize):
+    monkeypatch.setattr(main.settings, "auto_finalize_on_timeout", auto_finalize)
+    baseline_fds = open_descriptor_count()
+    baseline_sessions = set(main.AUDIO_STORAGE_PATH.glob("session_*"))
+    rounds = 10
+    
+    # Rounds of sessions abandoned mid-take, each round reaped before the next
+    for _ in range(rounds):
+        for _ in range(main.settings.max_open_sessions_per_user):
+            session_id = start_session(client)
+            for index in range(3):
+                assert upload(client, session_id, make_chunk(100, index), index=index).status_code == 200
+        
+        assert len(main.session_manager.sessions) == main.settings.max_open_sessions_per_user
+        assert reap_after_timeout() == main.settings.max_open_sessions_per_user
+        
+        assert main.session_manager.sessions == {}
+        assert open_descriptor_count() == baseline_fds
+        assert set(main.AUDIO_STORAGE_PATH.glob("session_*")) == baseline_sessions
+    
+    # Only the finished tracks remain, if any
+    expected_tracks = rounds * main.settings.max_open_sessions_per_user if auto_finalize else 0
+    assert len(main.tracks_db) == expected_tracks
@@ -0,0 +1,107 @@
+"""
+Chunk ingestion: parallel uploads arriving out of order, per-chunk CRC
+checks, and the chunk_hash finalize reports for end-to-end verification
+"""
+import struct
+import zlib
+
+from conftest import AUTH, make_chunk, read_track_samples, start_session, upload
+
+
+def test_out_of_order_chunks_assemble_in_index_order(client):
+    session_id = start_session(client)
+    
+    for index in (2, 0, 3, 1):
+        response = upload(client, session_id, make_chunk(100, index + 1), index=index)
+        assert response.status_code == 200
+    
+    response = client.post("/api/finalize-session", params={"session_id": session_id}, auth=AUTH)
+    assert response.status_code == 200
+    take = response.json()["takes"][0]
+    assert take["chunks"] == 4
+    
+    assert read_track_samples(take["track_id"]) == [1] * 100 + [2] * 100 + [3] * 100 + [4] * 100
+
+
+def test_out_of_order_chunks_keep_their_timeline_gaps(client):
+    session_id = start_session(client)
+    
+    # Chunk 1 starts 50 frames after chunk 0 ends, and arrives first
+    assert upload(client, session_id, make_chunk(100, 2), index=1, position=1150).status_code == 200
+    assert upload(client, session_id, make_chunk(100, 1), index=0, position=1000).status_code == 200
+    
+    response = client.post("/api/finalize-session", params={"session_id": session_id}, auth=AUTH)
+    take = response.json()["takes"][0]
+    assert take["host_start"] == 1000
+    assert read_track_samples(take["track_id"]) == [1] * 100 + [0] * 50 + [2] * 100
+
+
+def test_duplicate_chunk_is_ignored(client):
+    session_id = start_session(client)
+    chunk = make_chunk(100, 7)
+    
+    assert upload(client, session_id, chunk, index=0).status_code == 200
+    assert upload(client, session_id, chunk, index=0).status_code == 200
+    
+    response = client.post("/api/finalize-session", params={"session_id": session_id}, auth=AUTH)
+    assert response.json()["takes"][0]["chunks"] == 1
+
+
+def test_crc_mismatch_is_rejected(client):
+    session_id = start_session(client)
+    chunk = make_chunk(100, 5)
+    
+    response = upload(client, session_id, chunk, index=0, crc=zlib.crc32(chunk) ^ 1)
+    assert response.status_code == 400
+    assert "checksum" in response.json()["detail"].lower()
+    
+    # The rejected upload never becomes part of the take; a good retry does
+    assert upload(client, session_id, chunk, index=0, crc=zlib.crc32(chunk)).status_code == 200
+    
+    response = client.post("/api/finalize-session", params={"session_id": session_id}, auth=AUTH)
+    take = response.json()["takes"][0]
+    assert take["chunks"] == 1
+    assert read_track_samples(take["track_id"]) == [5] * 100
+
+
+def test_malformed_crc_header_is_rejected(client):
+    session_id = start_session(client)
+    response = client.post(
+        "/api/upload-chunk",
+        params={"session_id": session_id},
+        content=make_chunk(10, 1),
+        headers={"Content-Type": "audio/wav", "X-Chunk-CRC32": "not-hex"},
+        auth=AUTH
+    )
+    assert response.status_code == 400
+
+
+def test_finalize_reports_chunk_hash_over_chunk_crcs_in_order(client):
+    session_id = start_session(client)
+    chunks = [make_chunk(64 + index, index) for index in range(3)]
+    
+    # Sent out of order, hashed in assembly order
+    for index in (1, 2, 0):
+        assert upload(client, session_id, chunks[index], index=index, crc=zlib.crc32(chunks[index])).status_code == 200
+    
+    response = client.post("/api/finalize-session", params={"session_id": session_id}, auth=AUTH)
+    take = response.json()["takes"][0]
+    
+    expected = zlib.crc32(b"".join(struct.pack("<I", zlib.crc32(chunk)) for chunk in chunks))
+    assert take["chunk_hash"] == f"{expected:08x}"
+    assert take["chunks"] == 3
+
+
+def test_chunk_hash_changes_when_a_chunk_is_missing(client):
+    session_id = start_session(client)
+    chunks = [make_chunk(64, index) for index in range(3)]
+    
+    for index in (0, 2):
+        assert upload(client, session_id, chunks[index], index=index).status_code == 200
+    
+    response = client.post("/api/finalize-session", params={"session_id": session_id}, auth=AUTH)
+    take = response.json()["takes"][0]
+    
+    complete = zlib.crc32(b"".join(struct.pack("<I", zlib.crc32(chunk)) for chunk in chunks))
+    assert take["chunks"] == 2
+    assert take["chunk_hash"] != f"{complete:08x}"
@@ -0,0 +1,191 @@
+"""
+Minimal WAV reader/writer for the sample formats the plugin uploads
+
+The standard library's wave module only accepts integer PCM with the plain
+format tag, but chunks may also be 32-bit IEEE float, and other writers tag
+24-bit files as WAVE_FORMAT_EXTENSIBLE. Reading and writing go through here
+instead; the interface mirrors the parts of wave the backend uses, with
+params carrying an extra is_float flag.
+"""
+import builtins
+import struct
+from collections import namedtuple
+
+WAVE_FORMAT_PCM = 0x0001
+WAVE_FORMAT_IEEE_FLOAT = 0x0003
+WAVE_FORMAT_EXTENSIBLE = 0xFFFE
+
+HEADER_FORMAT = "<4sI4s4sIHHIIHH4sI"
+
+WavParams = namedtuple("WavParams", "nchannels sampwidth framerate nframes is_float")
+
+
+class Error(Exception):
+    pass
+
+
+def open(file, mode: str = "rb"):
+    """Open a path or binary file object for reading ('rb') or writing ('wb')"""
+    if mode not in ("rb", "wb"):
+        raise ValueError(f"Unsupported mode: {mode}")
+
+    owned = not hasattr(file, "read" if mode == "rb" else "write")
+    if owned:
+        file = builtins.open(file, mode)
+
+    try:
+        return WavReader(file, owned) if mode == "rb" else WavWriter(file, owned)
+    except Exception:
+        if owned:
+            file.close()
+        raise
+
+
+def same_format(a: WavParams, b: WavParams) -> bool:
+    """True when frames of a and b can be concatenated as-is"""
+    return a._replace(nframes=0) == b._replace(nframes=0)
+
+
+class WavReader:
+    """Reads PCM (8/16/24/32-bit) and 32-bit float WAV data"""
+
+    def __init__(self, file, owned: bool = False):
+        self._file = file
+        self._owned = owned
+
+        riff, _, wave_id = struct.unpack("<4sI4s", self._read_exact(12))
+        if riff != b"RIFF" or wave_id != b"WAVE":
+            raise Error("Not a WAV file")
+
+        fmt = None
+        while True:
+            header = file.read(8)
+            if len(header) < 8:
+                raise Error("No data chunk")
+            chunk_id, size = struct.unpack("<4sI", header)
+            if chunk_id == b"data":
+                break
+            if chunk_id == b"fmt ":
+                fmt = self._read_exact(size)
+                file.read(size % 2)
+            else:
+                file.seek(size + size % 2, 1)
+
+        if fmt is None or len(fmt) < 16:
+            raise Error("Missing fmt chunk")
+
+        tag, channels, rate, _, _, bits = struct.unpack("<HHIIHH", fmt[:16])
+        # The sub-format GUID starts with the real format tag
+        if tag == WAVE_FORMAT_EXTENSIBLE and len(fmt) >= 26:
+            tag = struct.unpack("<H", fmt[24:26])[0]
+        if tag not in (WAVE_FORMAT_PCM, WAVE_FORMAT_IEEE_FLOAT):
+            raise Error(f"Unsupported format: {tag}")
+
+        is_float = tag == WAVE_FORMAT_IEEE_FLOAT
+        sampwidth = (bits + 7) // 8
+        if channels == 0 or sampwidth not in (1, 2, 3, 4) or (is_float and sampwidth != 4):
+            raise Error(f"Unsupported layout: {channels} channel(s) of {bits} bits")
+
+        self._frame_bytes = channels * sampwidth
+        self._data_start = file.tell()
+        self._params = WavParams(channels, sampwidth, rate, size // self._frame_bytes, is_float)
+        self._position = 0
+
+    def _read_exact(self, size: int) -> bytes:
+        data = self._file.read(size)
+        if len(data) < size:
+            raise EOFError("Truncated WAV file")
+        return data
+
+    def getparams(self) -> WavParams:
+        return self._params
+
+    def getnchannels(self) -> int:
+        return self._params.nchannels
+
+    def getsampwidth(self) -> int:
+        return self._params.sampwidth
+
+    def getframerate(self) -> int:
+        return self._params.framerate
+
+    def getnframes(self) -> int:
+        return self._params.nframes
+
+    def setpos(self, position: int):
+        if not 0 <= position <= self._params.nframes:
+            raise Error("Position out of range")
+        self._file.seek(self._data_start + position * self._frame_bytes)
+        self._position = position
+
+    def readframes(self, count: int) -> bytes:
+        count = max(0, min(count, self._params.nframes - self._position))
+        data = self._file.read(count * self._frame_bytes)
+        self._position += len(data) // self._frame_bytes
+        return data
+
+    def close(self):
+        if self._owned:
+            self._file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+
+class WavWriter:
+    """Writes PCM or 32-bit float WAV; sizes are patched in on close"""
+
+    def __init__(self, file, owned: bool = False):
+        self._file = file
+        self._owned = owned
+        self._params = None
+        self._frames_written = 0
+        self._header_written = False
+
+    def setparams(self, params: WavParams):
+        if self._header_written:
+            raise Error("Cannot change parameters after writing frames")
+        self._params = params._replace(nframes=0)
+
+    def getnframes(self) -> int:
+        return self._frames_written
+
+    def _write_header(self, data_size: int):
+        params = self._params
+        block_align = params.nchannels * params.sampwidth
+        self._file.write(struct.pack(
+            HEADER_FORMAT, b"RIFF", 36 + data_size + data_size % 2, b"WAVE", b"fmt ", 16,
+            WAVE_FORMAT_IEEE_FLOAT if params.is_float else WAVE_FORMAT_PCM,
+            params.nchannels, params.framerate, params.framerate * block_align,
+            block_align, params.sampwidth * 8, b"data", data_size
+        ))
+
+    def writeframes(self, data: bytes):
+        if self._params is None:
+            raise Error("Parameters not set")
+        if not self._header_written:
+            self._write_header(0)
+            self._header_written = True
+        self._file.write(data)
+        self._frames_written += len(data) // (self._params.nchannels * self._params.sampwidth)
+
+    def close(self):
+        if self._params is not None:
+            data_size = self._frames_written * self._params.nchannels * self._params.sampwidth
+            if self._header_written:
+                # RIFF chunks are word aligned
+                self._file.write(b"\x00" * (data_size % 2))
+                self._file.seek(0)
+            self._write_header(data_size)
+            self._header_written = True
+        if self._owned:
+            self._file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
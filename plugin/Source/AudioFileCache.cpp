@@ -0,0 +1,75 @@
+#include "AudioFileCache.h"
+
+AudioFileCache::AudioFileCache()
+    : directory(juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                    .getChildFile("Auxlee")
+                    .getChildFile("TrackCache"))
+{
+}
+
+AudioFileCache::~AudioFileCache()
+{
+}
+
+void AudioFileCache::setMaxSizeBytes(juce::int64 newMaxSize)
+{
+    maxSizeBytes = juce::jmax((juce::int64) 0, newMaxSize);
+}
+
+juce::File AudioFileCache::getFileFor(const juce::String& trackId, const juce::String& etag) const
+{
+    auto name = juce::File::createLegalFileName(trackId + "_" + etag.retainCharacters("0123456789abcdefABCDEF-"));
+    return directory.getChildFile(name + ".wav");
+}
+
+juce::File AudioFileCache::getPartialFileFor(const juce::String& trackId) const
+{
+    return directory.getChildFile(juce::File::createLegalFileName(trackId) + ".part");
+}
+
+juce::File AudioFileCache::findTrack(const juce::String& trackId, const juce::String& etag) const
+{
+    if (etag.isEmpty())
+        return {};
+
+    auto file = getFileFor(trackId, etag);
+    if (!file.existsAsFile())
+        return {};
+
+    // Access time is our LRU clock; set it explicitly since many volumes mount noatime
+    file.setLastAccessTime(juce::Time::getCurrentTime());
+    return file;
+}
+
+void AudioFileCache::trim(const juce::Array<juce::File>& filesInUse)
+{
+    auto files = directory.findChildFiles(juce::File::findFiles, false, "*.wav");
+
+    juce::int64 totalSize = 0;
+    for (auto& file : files)
+        totalSize += file.getSize();
+
+    if (totalSize <= maxSizeBytes)
+        return;
+
+    std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b)
+    {
+        return a.getLastAccessTime() < b.getLastAccessTime();
+    });
+
+    for (auto& file : files)
+    {
+        if (totalSize <= maxSizeBytes)
+            break;
+
+        if (filesInUse.contains(file))
+            continue;
+
+        auto size = file.getSize();
+        if (file.deleteFile())
+        {
+            totalSize -= size;
+            DBG("Evicted cached track " + file.getFileName());
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// On-disk cache of downloaded tracks. Files are keyed by track id and the
+// server's ETag, and the least recently played ones are evicted once the
+// cache grows past its size limit.
+class AudioFileCache
+{
+public:
+    AudioFileCache();
+    ~AudioFileCache();
+
+    void setMaxSizeBytes(juce::int64 newMaxSize);
+    juce::int64 getMaxSizeBytes() const { return maxSizeBytes; }
+
+    // Returns the cached file for this version of the track, or an invalid
+    // File if it hasn't been downloaded yet. A hit counts as a use for LRU.
+    juce::File findTrack(const juce::String& trackId, const juce::String& etag) const;
+
+    // Where this version of the track lives once it has been downloaded
+    juce::File getFileFor(const juce::String& trackId, const juce::String& etag) const;
+
+    // Scratch location for an in-flight download; ignored by eviction
+    juce::File getPartialFileFor(const juce::String& trackId) const;
+
+    // Evicts least recently used files until the cache fits its limit,
+    // never touching the files that are still mapped for playback
+    void trim(const juce::Array<juce::File>& filesInUse);
+
+private:
+    juce::File directory;
+    juce::int64 maxSizeBytes = 1024LL * 1024 * 1024;
+};
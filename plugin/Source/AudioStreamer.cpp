@@ -1,84 +1,562 @@
 #include "AudioStreamer.h"
+#include "Crc32.h"
 
-AudioStreamer::AudioStreamer(NetworkClient* client)
-    : networkClient(client)
+AudioStreamer::AudioStreamer()
+    : juce::Thread("Auxlee Uploader")
 {
 }
 
 AudioStreamer::~AudioStreamer()
 {
     stop();
+    flush(5000);
+    stopThread(6000);
 }
 
-void AudioStreamer::prepare(double sampleRate, int blockSize)
+void AudioStreamer::prepare(double sampleRate, int blockSize, int numChannels)
 {
+    // Hosts may deliver blocks of any size, larger than announced included;
+    // the capture stage regroups them, so nothing here depends on blockSize
+    juce::ignoreUnused(blockSize);
+    numChannels = juce::jmax(1, numChannels);
+
+    // Hosts never call this during processBlock, so the capture stage is ours.
+    // Whatever it holds goes to the uploader, which encodes it while the old
+    // slots are still intact.
+    if (!chunks.isEmpty())
+    {
+        commitFrame();
+
+        if (fillingIndex >= 0)
+        {
+            if (chunks.getUnchecked(fillingIndex)->numSamples > 0)
+                publishFillingChunk();
+            else
+                fillingIndex = -1;
+        }
+
+        auto deadline = juce::Time::getMillisecondCounter() + 2000;
+        while (chunkFifo.getNumReady() > 0 && isThreadRunning() && juce::Time::getMillisecondCounter() < deadline)
+            juce::Thread::sleep(5);
+
+        if (chunkFifo.getNumReady() > 0)
+            DBG("Dropped " + juce::String(chunkFifo.getNumReady()) + " unencoded chunk(s) on prepare");
+    }
+
     currentSampleRate = sampleRate;
-    currentBlockSize = blockSize;
-    chunkSize = static_cast<int>(sampleRate * 2.0); // 2 seconds of audio
+    auto chunkSeconds = nonRealtime ? offlineChunkSeconds : realtimeChunkSeconds;
+    auto maxChunkSamples = maxChunkBytes / (numChannels * SampleKernels::getBytesPerSample(SampleFormat::float32));
+    chunkSize = juce::jmin(static_cast<int>(sampleRate * chunkSeconds), maxChunkSamples);
+    chunkSize = juce::jmax(1, chunkSize / captureFrameSize) * captureFrameSize;
+
+    // All chunk memory is allocated here, never on the audio thread
+    juce::ScopedLock lock(uploadLock);
+    chunks.clear();
+    for (int i = 0; i < chunkFifo.getTotalSize(); ++i)
+    {
+        auto* chunk = chunks.add(new Chunk());
+        chunk->audio.setSize(numChannels, chunkSize);
+    }
+
+    // The encode loops are chosen here, once per layout
+    for (int format = 0; format < SampleKernels::numFormats; ++format)
+        interleavers[static_cast<size_t>(format)] = SampleKernels::select(numChannels, static_cast<SampleFormat>(format));
+
+    chunkFifo.reset();
+    fillingIndex = -1;
+
+    frameBuffer.setSize(numChannels, captureFrameSize);
+    frameFill = 0;
+    silenceHoldFrames = static_cast<int>(sampleRate * silenceHoldSeconds) / captureFrameSize;
+    silentFrames = silenceHoldFrames;
+
+    prerollBuffer.setSize(numChannels, static_cast<int>(sampleRate * maxPrerollSeconds));
+    prerollBuffer.clear();
+    prerollWritePosition = 0;
+    prerollFilled = 0;
 }
 
 void AudioStreamer::start()
 {
-    juce::ScopedLock lock(bufferLock);
     isStreaming = true;
-    bufferQueue.setSize(2, chunkSize * 10); // Buffer for up to 20 seconds
-    bufferQueue.clear();
-    currentPosition = 0;
+
+    if (!isThreadRunning())
+        startThread();
 }
 
 void AudioStreamer::stop()
 {
+    if (!isStreaming)
+        return;
+
+    isStreaming = false;
+
+    // Wait for the audio thread to leave addAudioData before touching its slot
+    while (inAudioCallback.load())
+        juce::Thread::yield();
+
+    // Send remaining audio
+    commitFrame();
+    silentFrames = silenceHoldFrames;  // leading silence of the next take is skipped straight away
+
+    if (fillingIndex >= 0)
+    {
+        if (chunks[fillingIndex]->numSamples > 0)
+            publishFillingChunk();
+        else
+            fillingIndex = -1;
+    }
+}
+
+bool AudioStreamer::flush(int timeoutMs)
+{
+    auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(timeoutMs);
+    auto remainingMs = [deadline]
+    {
+        return static_cast<int>(juce::jmax<juce::int64>(0, static_cast<juce::int64>(deadline) - juce::Time::getMillisecondCounter()));
+    };
+
+    auto unqueued = [this] { return chunkFifo.getNumReady() + chunksBeingHandedOff.load(); };
+
+    while (unqueued() > 0 && isThreadRunning() && remainingMs() > 0)
+        juce::Thread::sleep(10);
+
+    if (unqueued() > 0)
+    {
+        DBG("Gave up waiting for " + juce::String(unqueued()) + " chunk(s) to encode");
+        return false;
+    }
+
+    juce::Array<UploadSink*> sinks;
+    {
+        juce::ScopedLock lock(sinksLock);
+        sinks = sessionSinks;
+    }
+
+    // The sinks drain side by side, so a dead one can't use up the time of the others
+    for (;;)
+    {
+        bool drained = true;
+        for (auto* sink : sinks)
+            drained = drained && sink->getNumPending() == 0;
+
+        if (drained)
+            return true;
+
+        if (remainingMs() == 0)
+            break;
+
+        juce::Thread::sleep(10);
+    }
+
+    for (auto* sink : sinks)
+        if (auto pending = sink->getNumPending())
+            DBG(sink->getName() + ": gave up waiting for " + juce::String(pending) + " chunk(s)");
+
+    return false;
+}
+
+void AudioStreamer::startTake(bool withPreroll)
+{
+    // The audio thread notices the new number and closes the previous take's chunk
+    ++currentTake;
+
+    if (withPreroll)
+        prerollPending = true;
+}
+
+void AudioStreamer::endTakeFromAudioThread()
+{
+    inAudioCallback = true;
+
     if (isStreaming)
     {
-        // Send remaining audio
-        if (currentPosition > 0)
+        commitFrame();
+        silentFrames = silenceHoldFrames;
+
+        if (fillingIndex >= 0 && chunks.getUnchecked(fillingIndex)->numSamples > 0)
+            publishFillingChunk();
+    }
+
+    inAudioCallback = false;
+}
+
+void AudioStreamer::addAudioData(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                 juce::Optional<juce::int64> hostPosition)
+{
+    inAudioCallback = true;
+
+    if (isStreaming && !chunks.isEmpty())
+    {
+        // First block of a take: the pre-roll goes in ahead of it
+        if (prerollPending.exchange(false))
+            flushPreroll(hostPosition);
+
+        captureFrames(buffer, startSample, numSamples, hostPosition);
+    }
+
+    inAudioCallback = false;
+}
+
+void AudioStreamer::pushPreroll(const juce::AudioBuffer<float>& buffer)
+{
+    auto capacity = prerollBuffer.getNumSamples();
+    if (capacity == 0)
+        return;
+
+    int numChannels = juce::jmin(buffer.getNumChannels(), prerollBuffer.getNumChannels());
+    int numSamples = buffer.getNumSamples();
+    int offset = juce::jmax(0, numSamples - capacity);  // only the newest samples fit
+
+    while (offset < numSamples)
+    {
+        int samplesToCopy = juce::jmin(numSamples - offset, capacity - prerollWritePosition);
+
+        for (int channel = 0; channel < prerollBuffer.getNumChannels(); ++channel)
         {
-            sendChunk();
+            if (channel < numChannels)
+                prerollBuffer.copyFrom(channel, prerollWritePosition, buffer, channel, offset, samplesToCopy);
+            else
+                prerollBuffer.clear(channel, prerollWritePosition, samplesToCopy);
         }
-        isStreaming = false;
+
+        prerollWritePosition = (prerollWritePosition + samplesToCopy) % capacity;
+        offset += samplesToCopy;
     }
+
+    prerollFilled = juce::jmin(capacity, prerollFilled + numSamples);
 }
 
-void AudioStreamer::addAudioData(const juce::AudioBuffer<float>& buffer)
+void AudioStreamer::setPrerollSeconds(double seconds)
 {
-    if (!isStreaming)
+    prerollSeconds = juce::jlimit(0.0, maxPrerollSeconds, seconds);
+}
+
+void AudioStreamer::flushPreroll(juce::Optional<juce::int64> hostPosition)
+{
+    auto capacity = prerollBuffer.getNumSamples();
+    auto available = juce::jmin(prerollFilled, static_cast<int>(prerollSeconds.load() * currentSampleRate), capacity);
+
+    if (available <= 0)
         return;
 
-    juce::ScopedLock lock(bufferLock);
+    // Oldest sample first, possibly wrapping around the end of the ring
+    auto start = (prerollWritePosition - available + capacity) % capacity;
+    auto firstPart = juce::jmin(available, capacity - start);
 
-    int numSamples = buffer.getNumSamples();
-    int numChannels = buffer.getNumChannels();
+    // The ring holds the blocks leading right up to this one, so it sits just before it on the timeline
+    juce::Optional<juce::int64> prerollPosition;
+    if (hostPosition)
+        prerollPosition = *hostPosition - available;
+
+    captureFrames(prerollBuffer, start, firstPart, prerollPosition);
+
+    if (prerollPosition)
+        prerollPosition = *prerollPosition + firstPart;
+
+    captureFrames(prerollBuffer, 0, available - firstPart, prerollPosition);
+
+    prerollFilled = 0;
+}
 
-    // Ensure buffer has space
-    if (currentPosition + numSamples > bufferQueue.getNumSamples())
+void AudioStreamer::captureFrames(const juce::AudioBuffer<float>& source, int startSample, int numSamples,
+                                  juce::Optional<juce::int64> hostPosition)
+{
+    int numChannels = juce::jmin(source.getNumChannels(), frameBuffer.getNumChannels());
+
+    // Audio that doesn't continue the partial frame on the timeline closes it early
+    if (frameFill > 0 && hostPosition && framePosition && *framePosition + frameFill != *hostPosition)
+        commitFrame();
+
+    int offset = 0;
+
+    while (offset < numSamples)
     {
-        // Send current chunk before overflow
-        sendChunk();
+        if (frameFill == 0)
+        {
+            framePosition.reset();
+            if (hostPosition)
+                framePosition = *hostPosition + offset;
+        }
+
+        int samplesToCopy = juce::jmin(numSamples - offset, captureFrameSize - frameFill);
+
+        for (int channel = 0; channel < frameBuffer.getNumChannels(); ++channel)
+        {
+            if (channel < numChannels)
+                frameBuffer.copyFrom(channel, frameFill, source, channel, startSample + offset, samplesToCopy);
+            else
+                frameBuffer.clear(channel, frameFill, samplesToCopy);
+        }
+
+        frameFill += samplesToCopy;
+        offset += samplesToCopy;
+
+        if (frameFill == captureFrameSize)
+            commitFrame();
     }
+}
 
-    // Copy audio data to buffer
-    for (int channel = 0; channel < juce::jmin(numChannels, bufferQueue.getNumChannels()); ++channel)
+void AudioStreamer::commitFrame()
+{
+    if (frameFill == 0)
+        return;
+
+    // Silence gate with hold: pauses shorter than the hold are sent as-is,
+    // longer ones are skipped and the backend restores them from the timeline
+    bool silent = true;
+    for (int channel = 0; channel < frameBuffer.getNumChannels() && silent; ++channel)
+        silent = frameBuffer.getMagnitude(channel, 0, frameFill) <= silenceThreshold;
+
+    silentFrames = silent ? silentFrames + 1 : 0;
+
+    if (silentFrames <= silenceHoldFrames)
+        appendToChunks(frameBuffer, 0, frameFill, framePosition);
+
+    frameFill = 0;
+}
+
+void AudioStreamer::appendToChunks(const juce::AudioBuffer<float>& source, int startSample, int numSamples,
+                                   juce::Optional<juce::int64> hostPosition)
+{
+    // The source is the frame buffer, prepared with the same channel count as the chunks
+    int numChannels = source.getNumChannels();
+    int take = currentTake.load();
+    int offset = 0;
+
+    while (offset < numSamples)
     {
-        bufferQueue.copyFrom(channel, currentPosition, buffer, channel, 0, numSamples);
+        juce::Optional<juce::int64> position;
+        if (hostPosition)
+            position = *hostPosition + offset;
+
+        // A chunk covers one take and one unbroken stretch of the host timeline,
+        // so the backend can put skipped silence back where it belongs
+        if (fillingIndex >= 0)
+        {
+            auto& filling = *chunks.getUnchecked(fillingIndex);
+            bool continuesTimeline = !position || !filling.hostPosition
+                                  || *filling.hostPosition + filling.numSamples == *position;
+
+            if (filling.take != take || !continuesTimeline)
+                publishFillingChunk();
+        }
+
+        if (fillingIndex < 0)
+        {
+            int start1, size1, start2, size2;
+            chunkFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+            if (size1 == 0)
+            {
+                // Bouncing offline: hold the render until the uploader catches up
+                if (nonRealtime && waitForFreeSlot())
+                    continue;
+
+                // Uploader has fallen too far behind; drop rather than block
+                droppedSamples += numSamples - offset;
+                break;
+            }
+
+            if (sessionSerial.load() != sessionOfLastChunk || take != takeOfLastChunk)
+            {
+                sessionOfLastChunk = sessionSerial.load();
+                takeOfLastChunk = take;
+                nextChunkIndex = 0;
+            }
+
+            fillingIndex = start1;
+            chunks.getUnchecked(fillingIndex)->numSamples = 0;
+            chunks.getUnchecked(fillingIndex)->sessionSerial = sessionSerial.load();
+            chunks.getUnchecked(fillingIndex)->take = take;
+            chunks.getUnchecked(fillingIndex)->index = nextChunkIndex++;
+            chunks.getUnchecked(fillingIndex)->hostPosition = position;
+        }
+
+        auto& chunk = *chunks.getUnchecked(fillingIndex);
+        int samplesToCopy = juce::jmin(numSamples - offset, chunkSize - chunk.numSamples);
+
+        // Copy audio data to buffer
+        for (int channel = 0; channel < chunk.audio.getNumChannels(); ++channel)
+        {
+            if (channel < numChannels)
+                chunk.audio.copyFrom(channel, chunk.numSamples, source, channel, startSample + offset, samplesToCopy);
+            else
+                chunk.audio.clear(channel, chunk.numSamples, samplesToCopy);
+        }
+
+        chunk.numSamples += samplesToCopy;
+        offset += samplesToCopy;
+
+        // Hand the chunk to the uploader once we've accumulated enough data
+        if (chunk.numSamples >= chunkSize)
+            publishFillingChunk();
     }
+}
 
-    currentPosition += numSamples;
+bool AudioStreamer::waitForFreeSlot()
+{
+    // Only ever reached from a non-realtime render, where blocking is allowed
+    while (chunkFifo.getFreeSpace() == 0)
+    {
+        if (!isStreaming || !isThreadRunning())
+            return false;
 
-    // Send chunk if we've accumulated enough data
-    if (currentPosition >= chunkSize)
+        slotFreed.wait(50);
+    }
+
+    return true;
+}
+
+void AudioStreamer::publishFillingChunk()
+{
+    chunks.getUnchecked(fillingIndex)->completedAtMs = juce::Time::getMillisecondCounter();
+    chunkFifo.finishedWrite(1);
+    fillingIndex = -1;
+}
+
+void AudioStreamer::run()
+{
+    while (!threadShouldExit())
     {
-        sendChunk();
+        if (chunkFifo.getNumReady() == 0)
+        {
+            oldestPendingMs = 0;
+            wait(20);
+            continue;
+        }
+
+        // Encode straight away so the slot goes back to the audio thread before the upload starts
+        auto encoded = std::make_shared<EncodedChunk>();
+        auto& audioData = encoded->data;
+        auto& info = encoded->info;
+        bool isCurrentSession = false;
+        {
+            juce::ScopedLock uploadScope(uploadLock);
+
+            // Read under the lock: prepare() may have reset the fifo since the check above
+            int start1, size1, start2, size2;
+            chunkFifo.prepareToRead(1, start1, size1, start2, size2);
+
+            if (size1 == 0)
+                continue;
+
+            auto& chunk = *chunks.getUnchecked(start1);
+            oldestPendingMs = chunk.completedAtMs;
+
+            isCurrentSession = chunk.sessionSerial == sessionSerial.load();
+            if (isCurrentSession && chunk.numSamples > 0)
+            {
+                if (chunk.sessionSerial != encodingSerial || chunk.take != encodingTake)
+                {
+                    encodingSerial = chunk.sessionSerial;
+                    encodingTake = chunk.take;
+                    takeBitrateKbps = lossyBitrateKbps.load();
+                    takeFormat = getSampleFormat();
+                }
+
+                auto encodeStart = juce::Time::getMillisecondCounterHiRes();
+
+                encoded->isOgg = takeBitrateKbps > 0 && encodeChunkLossy(chunk, takeBitrateKbps, audioData);
+                if (!encoded->isOgg)
+                    encodeChunk(chunk, takeFormat, audioData);
+
+                lastEncodeMs = static_cast<float>(juce::Time::getMillisecondCounterHiRes() - encodeStart);
+                uploadKbps = static_cast<int>(audioData.getSize() * 8 * currentSampleRate / (chunk.numSamples * 1000.0));
+            }
+
+            info.take = chunk.take;
+            info.index = chunk.index;
+            info.hostPosition = chunk.hostPosition;
+
+            // flush() must keep waiting until the sinks have it
+            ++chunksBeingHandedOff;
+            chunkFifo.finishedRead(1);
+        }
+
+        slotFreed.signal();
+
+        if (!isCurrentSession || audioData.isEmpty())
+        {
+            --chunksBeingHandedOff;
+            continue;
+        }
+
+        info.crc32 = Crc32::compute(audioData.getData(), audioData.getSize());
+
+        {
+            juce::ScopedLock lock(sessionLock);
+
+            // Chunks leave the fifo in index order, so the digest matches the backend's assembly order
+            auto& digest = takeDigests[info.take];
+            juce::uint8 crcBytes[4];
+            juce::ByteOrder::writeLittleEndianInt(crcBytes, info.crc32);
+            digest.hash = Crc32::compute(crcBytes, sizeof(crcBytes), digest.hash);
+            ++digest.numChunks;
+        }
+
+        juce::Array<UploadSink*> sinks;
+        {
+            juce::ScopedLock lock(sinksLock);
+            sinks = sessionSinks;
+        }
+
+        // One live request at a time while recording (plus one for backlog); several while bouncing
+        for (auto* sink : sinks)
+        {
+            sink->setMaxParallelDeliveries(nonRealtime ? maxParallelUploads : 1);
+
+            // A bounce waits for healthy sinks to catch up rather than dropping
+            // chunks; an unhealthy one never holds up the render
+            while (nonRealtime && sink->isHealthy() && !threadShouldExit() && !sink->waitForSpace(100))
+            {
+            }
+
+            sink->enqueue(encoded);
+        }
+
+        --chunksBeingHandedOff;
     }
 }
 
-void AudioStreamer::sendChunk()
+AudioStreamer::TakeDigest AudioStreamer::getTakeDigest(int take) const
 {
-    if (currentPosition == 0 || networkClient == nullptr)
+    juce::ScopedLock lock(sessionLock);
+    auto found = takeDigests.find(take);
+    return found != takeDigests.end() ? found->second : TakeDigest();
+}
+
+AudioStreamer::Statistics AudioStreamer::getStatistics() const
+{
+    Statistics stats;
+    stats.queuedChunks = chunkFifo.getNumReady();
+    stats.queueCapacity = chunkFifo.getTotalSize() - 1;
+    stats.droppedSamples = droppedSamples.load();
+    stats.lastEncodeMs = lastEncodeMs.load();
+    stats.uploadKbps = uploadKbps.load();
+
+    auto oldest = oldestPendingMs.load();
+    stats.uploadLagMs = oldest != 0 ? static_cast<int>(juce::Time::getMillisecondCounter() - oldest) : 0;
+
+    juce::ScopedLock lock(sinksLock);
+    for (auto* sink : sessionSinks)
+        stats.sinks.add(sink->getStatus());
+
+    if (!stats.sinks.isEmpty())
+    {
+        stats.chunksSent = stats.sinks.getReference(0).chunksSent;
+        stats.chunksFailed = stats.sinks.getReference(0).chunksFailed;
+        stats.lastUploadMs = stats.sinks.getReference(0).lastUploadMs;
+    }
+
+    return stats;
+}
+
+void AudioStreamer::encodeChunk(const Chunk& chunk, SampleFormat format, juce::MemoryBlock& audioData) const
+{
+    if (chunk.numSamples == 0)
         return;
 
-    // Prepare audio data for sending
-    juce::MemoryBlock audioData;
-    
     // Write WAV header information
     struct WavHeader
     {
@@ -97,35 +575,158 @@ void AudioStreamer::sendChunk()
         uint32_t dataSize;
     };
 
+    auto bytesPerSample = SampleKernels::getBytesPerSample(format);
+
     WavHeader header;
-    header.numChannels = static_cast<uint16_t>(bufferQueue.getNumChannels());
+    header.audioFormat = format == SampleFormat::float32 ? 3 : 1;  // IEEE float or PCM
+    header.bitsPerSample = static_cast<uint16_t>(bytesPerSample * 8);
+    header.numChannels = static_cast<uint16_t>(chunk.audio.getNumChannels());
     header.sampleRate = static_cast<uint32_t>(currentSampleRate);
     header.byteRate = header.sampleRate * header.numChannels * (header.bitsPerSample / 8);
     header.blockAlign = header.numChannels * (header.bitsPerSample / 8);
-    header.dataSize = currentPosition * header.numChannels * (header.bitsPerSample / 8);
-    header.fileSize = 36 + header.dataSize;
+    header.dataSize = chunk.numSamples * header.numChannels * (header.bitsPerSample / 8);
+    auto padding = header.dataSize & 1;  // 24-bit data can end on an odd byte
+    header.fileSize = 36 + header.dataSize + padding;
+
+    // Offline chunks are several MB, so size the block once and convert straight into it
+    audioData.setSize(sizeof(WavHeader) + header.dataSize + padding);
+    std::memcpy(audioData.getData(), &header, sizeof(WavHeader));
+    if (padding != 0)
+        audioData[audioData.getSize() - 1] = 0;
 
-    audioData.append(&header, sizeof(WavHeader));
+    auto interleave = interleavers[static_cast<size_t>(format)];
+    interleave(chunk.audio.getArrayOfReadPointers(), chunk.audio.getNumChannels(), chunk.numSamples,
+               static_cast<char*>(audioData.getData()) + sizeof(WavHeader));
+}
 
-    // Convert float samples to 16-bit PCM
-    for (int i = 0; i < currentPosition; ++i)
+bool AudioStreamer::encodeChunkLossy(const Chunk& chunk, int bitrateKbps, juce::MemoryBlock& audioData) const
+{
+    juce::OggVorbisAudioFormat format;
+
+    // The encoder works in quality steps labelled "64 kbps", "96 kbps", ...; take the closest
+    auto options = format.getQualityOptions();
+    int qualityIndex = 0;
+    for (int i = 1; i < options.size(); ++i)
     {
-        for (int channel = 0; channel < bufferQueue.getNumChannels(); ++channel)
-        {
-            float sample = bufferQueue.getSample(channel, i);
-            int16_t pcmSample = static_cast<int16_t>(juce::jlimit(-1.0f, 1.0f, sample) * 32767.0f);
-            audioData.append(&pcmSample, sizeof(int16_t));
-        }
+        if (std::abs(options[i].getIntValue() - bitrateKbps) < std::abs(options[qualityIndex].getIntValue() - bitrateKbps))
+            qualityIndex = i;
     }
 
-    // Send to network client
-    networkClient->sendAudioChunk(audioData, currentSessionId);
+    // Every chunk is a complete Ogg stream, so the backend can decode it on its own
+    auto* stream = new juce::MemoryOutputStream(audioData, false);
+    std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream, currentSampleRate,
+                                                                          static_cast<unsigned int>(chunk.audio.getNumChannels()),
+                                                                          16, {}, qualityIndex));
+    if (writer == nullptr)
+    {
+        delete stream;
+        DBG("Ogg Vorbis encoder unavailable, sending WAV");
+        return false;
+    }
+
+    bool written = writer->writeFromAudioSampleBuffer(chunk.audio, 0, chunk.numSamples);
+    writer.reset();  // finishes the stream
+
+    if (!written)
+        audioData.reset();
+
+    return written;
+}
+
+int AudioStreamer::findBestResult(const juce::Array<SinkResult>& results)
+{
+    int best = -1;
+    for (int i = 0; i < results.size(); ++i)
+    {
+        auto& result = results.getReference(i);
+        if (result.finished && result.numTakes > 0
+            && (best < 0 || result.unverifiedTakes < results.getReference(best).unverifiedTakes))
+            best = i;
+    }
 
-    // Reset position
-    currentPosition = 0;
+    if (best < 0)
+    {
+        for (int i = 0; i < results.size() && best < 0; ++i)
+            if (results.getReference(i).finished)
+                best = i;
+    }
+
+    return best;
 }
 
-void AudioStreamer::setSessionId(const juce::String& sessionId)
+void AudioStreamer::setSinks(const juce::Array<UploadSink*>& newSinks)
 {
-    currentSessionId = sessionId;
+    juce::ScopedLock lock(sinksLock);
+    configuredSinks = newSinks;
+}
+
+void AudioStreamer::beginSession()
+{
+    {
+        juce::ScopedLock lock(sessionLock);
+        takeDigests.clear();
+    }
+
+    // Anything still queued from an earlier session is dropped by the uploader
+    ++sessionSerial;
+    currentTake = 0;
+    droppedSamples = 0;
+
+    juce::Array<UploadSink*> sinks;
+    {
+        juce::ScopedLock lock(sinksLock);
+        sessionSinks = configuredSinks;
+        sinks = sessionSinks;
+    }
+
+    for (auto* sink : sinks)
+        sink->beginSession();
+}
+
+juce::Array<AudioStreamer::SinkResult> AudioStreamer::finishSession(int timeoutMs)
+{
+    // Finalizing assembles whatever has arrived, so let the sinks catch up first
+    flush(timeoutMs);
+
+    juce::Array<UploadSink*> sinks;
+    {
+        juce::ScopedLock lock(sinksLock);
+        sinks = sessionSinks;
+    }
+
+    juce::Array<SinkResult> results;
+
+    for (auto* sink : sinks)
+    {
+        SinkResult result;
+        result.name = sink->getName();
+
+        juce::Array<FinalizedTake> takes;
+        result.finished = sink->finishSession(takes);
+        result.numTakes = takes.size();
+
+        // The backend hashes the chunks it actually assembled; any lost, corrupted
+        // or misordered chunk shows up as a different hash without re-downloading
+        for (auto& take : takes)
+        {
+            auto digest = getTakeDigest(take.take);
+            if (digest.hash != take.chunkHash || digest.numChunks != take.numChunks)
+            {
+                ++result.unverifiedTakes;
+                DBG(result.name + ": take " + juce::String(take.take) + " doesn't match what was sent: "
+                    + juce::String(take.numChunks) + "/" + juce::String(digest.numChunks) + " chunks");
+            }
+        }
+
+        results.add(result);
+    }
+
+    // Late chunks of the finished session are dropped from here on
+    ++sessionSerial;
+    {
+        juce::ScopedLock lock(sinksLock);
+        sessionSinks.clear();
+    }
+
+    return results;
 }
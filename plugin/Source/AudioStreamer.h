@@ -1,33 +1,209 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "NetworkClient.h"
+#include "UploadSink.h"
+#include "SampleKernels.h"
 
-class AudioStreamer
+// Collects audio from the audio thread into preallocated chunk slots and
+// encodes finished chunks on a background thread, so processBlock never
+// waits on the network. Incoming audio is regrouped into fixed-size capture
+// frames first, so chunk contents don't depend on the host's block sizes.
+// Each encoded chunk is handed to every upload sink, and each sink delivers
+// from its own queue, so one slow or dead destination doesn't hold up the others.
+class AudioStreamer : private juce::Thread
 {
 public:
-    AudioStreamer(NetworkClient* client);
-    ~AudioStreamer();
+    struct Statistics
+    {
+        int queuedChunks = 0;
+        int queueCapacity = 0;
+        int chunksSent = 0;     // by the first sink
+        int chunksFailed = 0;
+        juce::int64 droppedSamples = 0;
+        int lastUploadMs = 0;
+        int uploadLagMs = 0;  // how long the oldest finished chunk has been waiting
+        float lastEncodeMs = 0.0f;
+        int uploadKbps = 0;   // encoded size of the last chunk per second of audio
+        juce::Array<UploadSink::Status> sinks;
+    };
 
-    void prepare(double sampleRate, int blockSize);
+    // How one sink fared when the session was finished
+    struct SinkResult
+    {
+        juce::String name;
+        bool finished = false;
+        int numTakes = 0;         // takes the destination assembled, 0 if it doesn't assemble
+        int unverifiedTakes = 0;  // of those, ones that don't match what was sent
+    };
+
+    AudioStreamer();
+    ~AudioStreamer() override;
+
+    // Chunks carry numChannels channels, normally the plugin's input layout.
+    // Audio already captured is handed to the uploader before the chunk
+    // memory is reallocated, so re-preparing mid-take (hosts do when they
+    // switch to an offline render) doesn't lose any.
+    void prepare(double sampleRate, int blockSize, int numChannels);
+
+    // Offline bounces run faster than real time: chunks get larger, several
+    // upload at once, and a full queue blocks the render instead of dropping
+    // audio. Takes effect for chunk sizes at the next prepare().
+    void setNonRealtime(bool isNonRealtime) { nonRealtime = isNonRealtime; }
+
+    // Arms/disarms capture. stop() hands the partial chunk to the uploader but
+    // doesn't wait for it; finishSession() drains everything first.
     void start();
     void stop();
-    void addAudioData(const juce::AudioBuffer<float>& buffer);
-    void setSessionId(const juce::String& sessionId);
+    bool flush(int timeoutMs);
+
+    // Begins the next take of the current session. Only touches atomics, so
+    // the audio thread can call it at a punch-in.
+    void startTake(bool withPreroll);
+    // Audio thread: closes the current take at a punch-out
+    void endTakeFromAudioThread();
+    int getCurrentTake() const { return currentTake.load(); }
+
+    // Any number of samples per call, whatever the prepared block size.
+    // hostPosition is the host timeline sample of startSample, if the transport is running.
+    void addAudioData(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                      juce::Optional<juce::int64> hostPosition);
+
+    // Destinations for the next session; the sinks must outlive the streamer
+    void setSinks(const juce::Array<UploadSink*>& newSinks);
+
+    // A new session drops anything still queued for the old one, restarts take
+    // numbering and starts sending to the sinks last passed to setSinks()
+    void beginSession();
+    // Drains every sink, closes the session on each and checks what each
+    // destination assembled against the chunk digests. Sinks that fail just
+    // report it here; they never affect the others.
+    juce::Array<SinkResult> finishSession(int timeoutMs);
+    // Failover: the first sink with the fewest unverified takes among those
+    // that assembled any; sinks that don't assemble (the local copy) only
+    // count if none did. -1 if no sink finished.
+    static int findBestResult(const juce::Array<SinkResult>& results);
+
+    // 0 uploads lossless 16-bit WAV; otherwise chunks are Ogg Vorbis at the
+    // nearest bitrate the encoder offers. Encoding runs on the uploader thread.
+    void setLossyBitrateKbps(int kbps) { lossyBitrateKbps = juce::jmax(0, kbps); }
+    int getLossyBitrateKbps() const { return lossyBitrateKbps.load(); }
+
+    // Sample format of lossless chunks. Both settings are latched when a
+    // take's first chunk is encoded, so a take never mixes formats.
+    using SampleFormat = SampleKernels::Format;
+    void setSampleFormat(SampleFormat format) { sampleFormat = static_cast<int>(format); }
+    SampleFormat getSampleFormat() const { return static_cast<SampleFormat>(sampleFormat.load()); }
+
+    // Always-on capture of the last few seconds, fed from every processBlock.
+    // startTake(true) prepends it to the take so audio from before the button
+    // press (and during the session round trip) isn't lost.
+    void pushPreroll(const juce::AudioBuffer<float>& buffer);
+    void setPrerollSeconds(double seconds);
+    double getPrerollSeconds() const { return prerollSeconds.load(); }
+    static constexpr double maxPrerollSeconds = 10.0;
+
+    // Safe to call from any thread; never waits on the audio or upload threads
+    Statistics getStatistics() const;
+
+    // Running CRC-32 over the CRCs of every chunk handed to the sinks for a
+    // take, in order. Matches the backend's chunk_hash when nothing was lost.
+    struct TakeDigest
+    {
+        juce::uint32 hash = 0;
+        int numChunks = 0;
+    };
+    TakeDigest getTakeDigest(int take) const;
 
 private:
-    void sendChunk();
+    struct Chunk
+    {
+        juce::AudioBuffer<float> audio;
+        int numSamples = 0;
+        int sessionSerial = 0;
+        int take = 0;
+        int index = 0;  // position within the take, so parallel uploads can be reordered
+        juce::Optional<juce::int64> hostPosition;  // of the first sample
+        juce::uint32 completedAtMs = 0;
+    };
+
+    void run() override;
+    void appendToChunks(const juce::AudioBuffer<float>& source, int startSample, int numSamples,
+                        juce::Optional<juce::int64> hostPosition);
+    void flushPreroll(juce::Optional<juce::int64> hostPosition);
+    void captureFrames(const juce::AudioBuffer<float>& source, int startSample, int numSamples,
+                       juce::Optional<juce::int64> hostPosition);
+    void commitFrame();
+    bool waitForFreeSlot();
+    void publishFillingChunk();
+    void encodeChunk(const Chunk& chunk, SampleFormat format, juce::MemoryBlock& audioData) const;
+    bool encodeChunkLossy(const Chunk& chunk, int bitrateKbps, juce::MemoryBlock& audioData) const;
+
+    static constexpr int numChunkSlots = 10;  // Buffer for up to 20 seconds
+    juce::OwnedArray<Chunk> chunks;
+    juce::AbstractFifo chunkFifo{ numChunkSlots };
+    int fillingIndex = -1;  // slot the audio thread is writing, or -1
 
-    NetworkClient* networkClient;
-    juce::AudioBuffer<float> bufferQueue;
-    juce::CriticalSection bufferLock;
-    
     double currentSampleRate = 44100.0;
-    int currentBlockSize = 512;
-    int chunkSize = 44100 * 2; // 2 seconds worth of samples
-    int currentPosition = 0;
-    juce::String currentSessionId;
-    
+    int chunkSize = 44100 * 2; // 2 seconds worth of samples, a whole number of capture frames
+    static constexpr double realtimeChunkSeconds = 2.0;
+    static constexpr double offlineChunkSeconds = 8.0;
+    // Whatever the rate, channel count and sample format, an encoded chunk
+    // stays under the backend's default upload limit (max_chunk_size_mb = 10)
+    static constexpr int maxChunkBytes = 8 * 1024 * 1024;
+    std::atomic<bool> nonRealtime{ false };
+
+    // Capture stage; audio thread only apart from prepare() and stop()
+    static constexpr int captureFrameSize = 256;
+    static constexpr float silenceThreshold = 0.0001f;  // -80 dB
+    static constexpr double silenceHoldSeconds = 1.0;   // short pauses are kept so chunks stay whole
+    juce::AudioBuffer<float> frameBuffer;
+    int frameFill = 0;
+    juce::Optional<juce::int64> framePosition;
+    int silentFrames = 0;
+    int silenceHoldFrames = 0;
+
+    // A bounce keeps several requests in flight per sink
+    static constexpr int maxParallelUploads = 4;
+    juce::WaitableEvent slotFreed;
+
+    mutable juce::CriticalSection sinksLock;
+    juce::Array<UploadSink*> configuredSinks;  // for the next session
+    juce::Array<UploadSink*> sessionSinks;     // receiving the current one
+
+    juce::CriticalSection uploadLock;   // held by the uploader from taking a slot to releasing it, so prepare() can't reallocate or reset under it
+    mutable juce::CriticalSection sessionLock;  // never taken on the audio thread
+    std::map<int, TakeDigest> takeDigests;  // guarded by sessionLock
+    std::atomic<int> sessionSerial{ 0 };
+    std::atomic<int> currentTake{ 0 };
+    // Audio thread only: numbering of chunks within the current take
+    int sessionOfLastChunk = 0;
+    int takeOfLastChunk = 0;
+    int nextChunkIndex = 0;
+
+    // Ring buffer sized for maxPrerollSeconds; audio thread only apart from prepare()
+    juce::AudioBuffer<float> prerollBuffer;
+    int prerollWritePosition = 0;
+    int prerollFilled = 0;
+    std::atomic<double> prerollSeconds{ 3.0 };
+    std::atomic<bool> prerollPending{ false };
+
     std::atomic<bool> isStreaming{ false };
-    std::unique_ptr<juce::Thread> streamThread;
+    std::atomic<bool> inAudioCallback{ false };
+
+    std::atomic<juce::int64> droppedSamples{ 0 };
+    std::atomic<int> lossyBitrateKbps{ 0 };
+    std::atomic<int> sampleFormat{ static_cast<int>(SampleFormat::int16) };
+
+    // One kernel per output format for the prepared channel count, indexed by SampleFormat
+    std::array<SampleKernels::Interleaver, SampleKernels::numFormats> interleavers{};
+
+    // Uploader thread only: encoding settings of the take being encoded
+    int encodingSerial = -1;
+    int encodingTake = -1;
+    int takeBitrateKbps = 0;
+    SampleFormat takeFormat = SampleFormat::int16;
+    std::atomic<float> lastEncodeMs{ 0.0f };
+    std::atomic<int> uploadKbps{ 0 };
+    std::atomic<juce::uint32> oldestPendingMs{ 0 };
+    std::atomic<int> chunksBeingHandedOff{ 0 };  // out of the fifo but not yet queued on every sink
 };
@@ -0,0 +1,145 @@
+#include "ConnectionWarmup.h"
+
+ConnectionWarmup::ConnectionWarmup()
+    : juce::Thread("Auxlee Connection Warm-up")
+{
+    startThread();
+}
+
+ConnectionWarmup::~ConnectionWarmup()
+{
+    // A check in progress stops after the request it is waiting on, which
+    // times out well within this
+    stopThread(10000);
+}
+
+juce::String ConnectionWarmup::makeKey(const juce::String& apiUrl, const juce::String& username)
+{
+    return apiUrl + "|" + username;
+}
+
+void ConnectionWarmup::request(const juce::String& apiUrl, const juce::String& username, const juce::String& password, bool refresh)
+{
+    if (apiUrl.isEmpty())
+        return;
+
+    {
+        juce::ScopedLock lock(entriesLock);
+        auto& entry = entries[makeKey(apiUrl, username)];
+        entry.apiUrl = apiUrl;
+        entry.username = username;
+
+        bool newPassword = password.isNotEmpty() && password != entry.password;
+        if (newPassword)
+            entry.password = password;
+
+        if (!(refresh || newPassword || entry.status.state == State::idle))
+            return;
+
+        entry.pending = true;
+    }
+
+    notify();
+}
+
+ConnectionWarmup::Status ConnectionWarmup::getStatus(const juce::String& apiUrl, const juce::String& username) const
+{
+    juce::ScopedLock lock(entriesLock);
+    auto found = entries.find(makeKey(apiUrl, username));
+    return found != entries.end() ? found->second.status : Status();
+}
+
+void ConnectionWarmup::run()
+{
+    while (!threadShouldExit())
+    {
+        juce::String key;
+        {
+            juce::ScopedLock lock(entriesLock);
+            for (auto& [entryKey, entry] : entries)
+            {
+                if (entry.pending)
+                {
+                    key = entryKey;
+                    entry.pending = false;
+                    entry.status.state = State::checking;
+                    break;
+                }
+            }
+        }
+
+        if (key.isEmpty())
+        {
+            wait(-1);
+            continue;
+        }
+
+        sendChangeMessage();
+        check(key);
+        sendChangeMessage();
+    }
+}
+
+void ConnectionWarmup::check(const juce::String& key)
+{
+    NetworkClient client;
+    juce::String apiUrl, username, password;
+    {
+        juce::ScopedLock lock(entriesLock);
+        auto& entry = entries[key];
+        apiUrl = entry.apiUrl;
+        username = entry.username;
+        password = entry.password;
+    }
+
+    client.setApiUrl(apiUrl);
+    client.setAuthentication(username, password);
+
+    auto state = State::unreachable;
+    bool synced = false;
+
+    if (client.testConnection())
+    {
+        state = State::reachable;
+
+        if (password.isNotEmpty() && !threadShouldExit())
+        {
+            auto statusCode = client.checkCredentials();
+
+            if (statusCode == 401 || statusCode == 403)
+            {
+                state = State::rejected;
+            }
+            else if (statusCode != 200)
+            {
+                state = State::failed;
+            }
+            else
+            {
+                TrackCache cache;
+                cache.open(apiUrl, username);
+
+                bool listChanged = false;
+                synced = cache.sync(client, listChanged, [this] { return threadShouldExit(); });
+                state = synced ? State::signedIn : State::failed;
+            }
+        }
+    }
+
+    DBG("Warm-up " + apiUrl + " (" + username + "): state " + juce::String(static_cast<int>(state)));
+
+    juce::ScopedLock lock(entriesLock);
+    auto& entry = entries[key];
+    entry.status.state = state;
+
+    if (synced)
+    {
+        entry.status.password = password;
+        ++entry.status.syncCount;
+    }
+    else if (state == State::rejected && entry.password == password)
+    {
+        // Later refreshes go back to the password that last worked, if any
+        entry.password = entry.status.password;
+    }
+}
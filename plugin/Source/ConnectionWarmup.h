@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "NetworkClient.h"
+#include "TrackCache.h"
+
+// One per process, shared through juce::SharedResourcePointer, so plugin
+// instances never touch the network on the thread that creates or restores
+// them. A background thread checks each server/user pair once: it contacts
+// the server (resolving it and opening a connection the platform's HTTP stack
+// can reuse) and, once a password is known, checks it with an authenticated
+// request and syncs the shared on-disk track list. A project with a hundred
+// instances on the same server costs one check, and a password the server
+// accepted in any instance signs in the rest; a rejected one is never shared.
+// Listeners are told about every change on the message thread.
+class ConnectionWarmup : public juce::ChangeBroadcaster,
+                         private juce::Thread
+{
+public:
+    enum class State
+    {
+        idle,
+        checking,
+        unreachable,
+        reachable,  // the server answered but no password is known yet
+        signedIn,   // credentials accepted and the track list synced
+        rejected,   // the server refused the username or password
+        failed      // the server answered but the check or the sync failed
+    };
+
+    struct Status
+    {
+        State state = State::idle;
+        juce::String password;  // as last accepted by the server, kept in memory only
+        int syncCount = 0;      // bumped after every sync that reached the track cache
+    };
+
+    ConnectionWarmup();
+    ~ConnectionWarmup() override;
+
+    // Never blocks. Pairs already checked are left alone unless refresh is set,
+    // which re-checks and re-syncs the track list. A new password always signs in again.
+    void request(const juce::String& apiUrl, const juce::String& username, const juce::String& password, bool refresh);
+    Status getStatus(const juce::String& apiUrl, const juce::String& username) const;
+
+private:
+    struct Entry
+    {
+        juce::String apiUrl;
+        juce::String username;
+        juce::String password;
+        Status status;
+        bool pending = false;
+    };
+
+    static juce::String makeKey(const juce::String& apiUrl, const juce::String& username);
+    void run() override;
+    void check(const juce::String& key);
+
+    mutable juce::CriticalSection entriesLock;
+    std::map<juce::String, Entry> entries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConnectionWarmup)
+};
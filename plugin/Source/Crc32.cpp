@@ -0,0 +1,56 @@
+#include "Crc32.h"
+
+namespace
+{
+    struct Crc32Tables
+    {
+        Crc32Tables()
+        {
+            for (juce::uint32 i = 0; i < 256; ++i)
+            {
+                auto value = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    value = (value & 1) != 0 ? (value >> 1) ^ 0xedb88320u : value >> 1;
+
+                table[0][i] = value;
+            }
+
+            // table[n][i] is the CRC of byte i followed by n zero bytes
+            for (int slice = 1; slice < 8; ++slice)
+                for (int i = 0; i < 256; ++i)
+                    table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xff];
+        }
+
+        juce::uint32 table[8][256];
+    };
+
+    const Crc32Tables& getTables()
+    {
+        static const Crc32Tables tables;
+        return tables;
+    }
+}
+
+juce::uint32 Crc32::compute(const void* data, size_t numBytes, juce::uint32 crc)
+{
+    auto& table = getTables().table;
+    auto* bytes = static_cast<const juce::uint8*>(data);
+    crc = ~crc;
+
+    while (numBytes >= 8)
+    {
+        auto low = crc ^ juce::ByteOrder::littleEndianInt(bytes);
+        auto high = juce::ByteOrder::littleEndianInt(bytes + 4);
+
+        crc = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^ table[5][(low >> 16) & 0xff] ^ table[4][low >> 24]
+            ^ table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff] ^ table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+
+        bytes += 8;
+        numBytes -= 8;
+    }
+
+    while (numBytes-- > 0)
+        crc = table[0][(crc ^ *bytes++) & 0xff] ^ (crc >> 8);
+
+    return ~crc;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// CRC-32 with the zlib/PNG polynomial, so the backend can check it with
+// zlib.crc32. Processes eight bytes per step (slice-by-8), which keeps it
+// well under a millisecond for a chunk.
+class Crc32
+{
+public:
+    // Pass the previous result as crc to continue a running checksum
+    static juce::uint32 compute(const void* data, size_t numBytes, juce::uint32 crc = 0);
+};
@@ -0,0 +1,50 @@
+#include "FileUploadSink.h"
+
+FileUploadSink::FileUploadSink(const juce::File& rootDirectory)
+    : UploadSink("Local copy"),
+      root(rootDirectory)
+{
+}
+
+FileUploadSink::~FileUploadSink()
+{
+    shutdown();
+}
+
+juce::File FileUploadSink::getSessionDirectory() const
+{
+    juce::ScopedLock lock(directoryLock);
+    return sessionDirectory;
+}
+
+void FileUploadSink::sessionStarted()
+{
+    juce::ScopedLock lock(directoryLock);
+    sessionDirectory = root.getChildFile("Session " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S"));
+}
+
+UploadSink::DeliveryResult FileUploadSink::deliver(const EncodedChunk& chunk)
+{
+    // A full or unplugged disk can come back, so write errors are retried
+    auto directory = getSessionDirectory();
+    if (directory == juce::File() || !directory.createDirectory())
+        return DeliveryResult::failed;
+
+    // One self-contained file per chunk, zero-padded so the folder sorts into take and chunk order
+    auto fileName = juce::String::formatted("take_%03d_chunk_%04d", chunk.info.take, chunk.info.index)
+                  + (chunk.isOgg ? ".ogg" : ".wav");
+
+    return directory.getChildFile(fileName).replaceWithData(chunk.data.getData(), chunk.data.getSize())
+               ? DeliveryResult::delivered
+               : DeliveryResult::failed;
+}
+
+bool FileUploadSink::finishSession(juce::Array<FinalizedTake>& takes)
+{
+    // Nothing is assembled locally; the chunks are the copy
+    juce::ignoreUnused(takes);
+
+    auto status = getStatus();
+    DBG("Local copy: " + juce::String(status.chunksSent) + " chunk(s) in " + getSessionDirectory().getFullPathName());
+    return status.chunksSent > 0 && status.chunksDropped == 0;
+}
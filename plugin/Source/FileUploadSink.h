@@ -0,0 +1,29 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "UploadSink.h"
+
+// Keeps a local copy of every chunk as it was encoded, one folder per
+// session, so a recording survives even if no server received it.
+class FileUploadSink : public UploadSink
+{
+public:
+    explicit FileUploadSink(const juce::File& rootDirectory);
+    ~FileUploadSink() override;
+
+    juce::File getSessionDirectory() const;
+
+    bool finishSession(juce::Array<FinalizedTake>& takes) override;
+
+protected:
+    DeliveryResult deliver(const EncodedChunk& chunk) override;
+    void sessionStarted() override;
+
+private:
+    juce::File root;
+
+    mutable juce::CriticalSection directoryLock;
+    juce::File sessionDirectory;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FileUploadSink)
+};
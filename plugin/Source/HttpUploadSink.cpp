@@ -0,0 +1,127 @@
+#include "HttpUploadSink.h"
+
+HttpUploadSink::HttpUploadSink(const juce::String& sinkName)
+    : UploadSink(sinkName)
+{
+}
+
+HttpUploadSink::~HttpUploadSink()
+{
+    shutdown();
+}
+
+void HttpUploadSink::setServer(const juce::String& url, const juce::String& newUsername, const juce::String& newPassword)
+{
+    juce::ScopedLock lock(serverLock);
+    apiUrl = url;
+    username = newUsername;
+    password = newPassword;
+}
+
+bool HttpUploadSink::hasServer() const
+{
+    juce::ScopedLock lock(serverLock);
+    return apiUrl.isNotEmpty();
+}
+
+void HttpUploadSink::configure(NetworkClient& client) const
+{
+    juce::ScopedLock lock(serverLock);
+    client.setApiUrl(apiUrl);
+    client.setAuthentication(username, password);
+}
+
+void HttpUploadSink::sessionStarted()
+{
+    juce::ScopedLock lock(remoteSessionLock);
+    remoteSessionId = {};
+    sessionFinished = false;
+}
+
+juce::String HttpUploadSink::ensureRemoteSession()
+{
+    juce::ScopedLock lock(remoteSessionLock);
+
+    if (remoteSessionId.isEmpty() && !sessionFinished)
+    {
+        NetworkClient client;
+        configure(client);
+        remoteSessionId = client.startSession();
+
+        if (remoteSessionId.isNotEmpty())
+            DBG(getName() + ": started session " + remoteSessionId);
+    }
+
+    return remoteSessionId;
+}
+
+UploadSink::DeliveryResult HttpUploadSink::deliver(const EncodedChunk& chunk)
+{
+    auto sessionId = ensureRemoteSession();
+    if (sessionId.isEmpty())
+        return DeliveryResult::failed;
+
+    // A client per request keeps parallel uploads independent of setServer()
+    NetworkClient client;
+    configure(client);
+    auto statusCode = client.sendAudioChunk(chunk.data, sessionId, chunk.info);
+
+    // The backend reaps sessions that sat idle (a long outage, a paused
+    // session); carry on in a new one rather than losing every later chunk
+    if (statusCode == 404)
+    {
+        {
+            juce::ScopedLock lock(remoteSessionLock);
+            if (remoteSessionId == sessionId)
+                remoteSessionId = {};
+        }
+
+        DBG(getName() + ": session " + sessionId + " is gone on the server");
+        sessionId = ensureRemoteSession();
+        if (sessionId.isEmpty())
+            return DeliveryResult::failed;
+
+        statusCode = client.sendAudioChunk(chunk.data, sessionId, chunk.info);
+    }
+
+    return resultForStatus(statusCode);
+}
+
+UploadSink::DeliveryResult HttpUploadSink::resultForStatus(int statusCode)
+{
+    if (statusCode == 200)
+        return DeliveryResult::delivered;
+
+    // Timeouts, throttling, server errors and a session that couldn't be
+    // reopened clear up on their own; any other 4xx is about the chunk itself
+    bool chunkRefused = statusCode >= 400 && statusCode < 500
+                     && statusCode != 404 && statusCode != 408 && statusCode != 429;
+
+    return chunkRefused ? DeliveryResult::rejected : DeliveryResult::failed;
+}
+
+bool HttpUploadSink::finishSession(juce::Array<FinalizedTake>& takes)
+{
+    // Chunks still queued after a flush that timed out would otherwise open a
+    // new remote session of their own once the id is cleared
+    juce::String sessionId;
+    {
+        juce::ScopedLock lock(remoteSessionLock);
+        sessionId = remoteSessionId;
+        remoteSessionId = {};
+        sessionFinished = true;
+    }
+
+    dropPendingChunks();
+
+    // Nothing ever reached this server
+    if (sessionId.isEmpty())
+        return false;
+
+    NetworkClient client;
+    configure(client);
+    bool finalized = client.finalizeSession(sessionId, takes);
+    DBG(getName() + ": finalized session " + sessionId);
+
+    return finalized;
+}
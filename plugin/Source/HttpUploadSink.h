@@ -0,0 +1,39 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "UploadSink.h"
+
+// Uploads chunks to one Auxlee backend. The backend session is opened by the
+// first delivery, so a server that's down only shows up as an unhealthy sink
+// and never delays starting a take.
+class HttpUploadSink : public UploadSink
+{
+public:
+    explicit HttpUploadSink(const juce::String& sinkName);
+    ~HttpUploadSink() override;
+
+    void setServer(const juce::String& url, const juce::String& username, const juce::String& password);
+    bool hasServer() const;
+
+    bool finishSession(juce::Array<FinalizedTake>& takes) override;
+
+protected:
+    DeliveryResult deliver(const EncodedChunk& chunk) override;
+    void sessionStarted() override;
+
+private:
+    void configure(NetworkClient& client) const;
+    juce::String ensureRemoteSession();
+    static DeliveryResult resultForStatus(int statusCode);
+
+    mutable juce::CriticalSection serverLock;
+    juce::String apiUrl;
+    juce::String username;
+    juce::String password;
+
+    juce::CriticalSection remoteSessionLock;  // one start-session request at a time
+    juce::String remoteSessionId;
+    bool sessionFinished = false;  // no new remote session until the next beginSession()
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HttpUploadSink)
+};
@@ -0,0 +1,45 @@
+#include "LevelMeter.h"
+
+LevelMeter::LevelMeter()
+{
+    setOpaque(true);
+}
+
+LevelMeter::~LevelMeter()
+{
+}
+
+void LevelMeter::setLevels(float newLevel, float newPeak)
+{
+    newLevel = juce::jlimit(0.0f, 1.0f, newLevel);
+    newPeak = juce::jlimit(0.0f, 1.0f, newPeak);
+
+    if (newLevel != level || newPeak != peak)
+    {
+        level = newLevel;
+        peak = newPeak;
+        repaint();
+    }
+}
+
+void LevelMeter::setBarColour(juce::Colour newColour)
+{
+    barColour = newColour;
+    repaint();
+}
+
+void LevelMeter::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.fillAll(juce::Colours::black);
+
+    g.setColour(barColour);
+    g.fillRect(bounds.withWidth(bounds.getWidth() * level));
+
+    if (peak > 0.0f)
+    {
+        g.setColour(juce::Colours::white);
+        g.fillRect(bounds.getX() + bounds.getWidth() * peak - 1.0f, bounds.getY(), 2.0f, bounds.getHeight());
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Horizontal bar with a peak-hold tick. Values are pushed in from the
+// editor's timer; the meter itself never talks to the audio thread.
+class LevelMeter : public juce::Component
+{
+public:
+    LevelMeter();
+    ~LevelMeter() override;
+
+    // Both in 0..1 of the bar width
+    void setLevels(float newLevel, float newPeak);
+    void setBarColour(juce::Colour newColour);
+
+    void paint(juce::Graphics&) override;
+
+private:
+    float level = 0.0f;
+    float peak = 0.0f;
+    juce::Colour barColour = juce::Colours::limegreen;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeter)
+};
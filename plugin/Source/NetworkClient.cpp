@@ -59,6 +59,29 @@ bool NetworkClient::testConnection()
     return false;
 }
 
+int NetworkClient::checkCredentials()
+{
+    if (apiUrl.isEmpty())
+        return 0;
+
+    juce::URL url(apiUrl + "/api/tracks/changes");
+    url = url.withParameter("since", "0")
+             .withParameter("limit", "1");
+    
+    juce::String headers;
+    headers << "Authorization: " << getAuthHeader() << "\r\n";
+
+    int statusCode = 0;
+    std::unique_ptr<juce::InputStream> response(url.createInputStream(
+        juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inAddress)
+            .withExtraHeaders(headers)
+            .withConnectionTimeoutMs(5000)
+            .withStatusCode(&statusCode)
+    ));
+
+    return response != nullptr ? statusCode : 0;
+}
+
 juce::String NetworkClient::startSession()
 {
     if (apiUrl.isEmpty())
@@ -94,7 +117,7 @@ juce::String NetworkClient::startSession()
     return "";
 }
 
-bool NetworkClient::finalizeSession(const juce::String& sessionId)
+bool NetworkClient::finalizeSession(const juce::String& sessionId, juce::Array<FinalizedTake>& takes)
 {
     if (apiUrl.isEmpty() || sessionId.isEmpty())
         return false;
@@ -105,114 +128,162 @@ bool NetworkClient::finalizeSession(const juce::String& sessionId)
     juce::String headers;
     headers << "Authorization: " << getAuthHeader() << "\r\n";
 
+    int statusCode = 0;
     std::unique_ptr<juce::InputStream> response(url.createInputStream(
         juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inAddress)
             .withExtraHeaders(headers)
             .withConnectionTimeoutMs(5000)
             .withHttpRequestCmd("POST")
+            .withStatusCode(&statusCode)
     ));
 
-    if (response != nullptr)
+    if (response != nullptr && statusCode == 200)
     {
         juce::String responseText = response->readEntireStreamAsString();
         DBG("Finalize session response: " + responseText);
+        
+        juce::var json;
+        if (juce::JSON::parse(responseText, json).wasOk())
+        {
+            if (auto* takeList = json["takes"].getArray())
+            {
+                for (auto& entry : *takeList)
+                {
+                    FinalizedTake take;
+                    take.take = static_cast<int>(entry["take"]);
+                    take.trackId = entry["track_id"].toString();
+                    take.numChunks = static_cast<int>(entry["chunks"]);
+                    take.chunkHash = static_cast<juce::uint32>(entry["chunk_hash"].toString().getHexValue32());
+                    takes.add(take);
+                }
+            }
+        }
+        
         return true;
     }
 
     return false;
 }
 
-bool NetworkClient::sendAudioChunk(const juce::MemoryBlock& audioData, const juce::String& sessionId)
+int NetworkClient::sendAudioChunk(const juce::MemoryBlock& audioData, const juce::String& sessionId, const ChunkInfo& chunk)
 {
     if (apiUrl.isEmpty())
-        return false;
+        return 0;
 
-    // Create multipart boundary
-    juce::String boundary = "----JUCEAudioBoundary" + juce::String(juce::Random::getSystemRandom().nextInt64());
-    
-    // Build multipart form data
-    juce::MemoryBlock formData;
-    juce::MemoryOutputStream stream(formData, false);
-    
-    // Write form field
-    stream << "--" << boundary << "\r\n";
-    stream << "Content-Disposition: form-data; name=\"file\"; filename=\"chunk.wav\"\r\n";
-    stream << "Content-Type: audio/wav\r\n\r\n";
-    
-    // Write audio data
-    stream.write(audioData.getData(), audioData.getSize());
-    
-    // Write closing boundary
-    stream << "\r\n--" << boundary << "--\r\n";
+    // Chunks are either WAV or a self-contained Ogg Vorbis stream. They go as
+    // the raw request body, which the backend streams straight to disk.
+    bool isOgg = audioData.getSize() >= 4 && std::memcmp(audioData.getData(), "OggS", 4) == 0;
     
     // Prepare headers
     juce::String headers;
     headers << "Authorization: " << getAuthHeader() << "\r\n";
-    headers << "Content-Type: multipart/form-data; boundary=" << boundary << "\r\n";
+    headers << "Content-Type: " << (isOgg ? "audio/ogg" : "audio/wav") << "\r\n";
+    headers << "X-Chunk-CRC32: " << juce::String::toHexString(static_cast<int>(chunk.crc32)).paddedLeft('0', 8) << "\r\n";
     
     // Send POST request with body and session_id parameter
     juce::URL url(apiUrl + "/api/upload-chunk");
     if (sessionId.isNotEmpty())
         url = url.withParameter("session_id", sessionId);
-    url = url.withPOSTData(formData);
+    url = url.withParameter("take", juce::String(chunk.take))
+             .withParameter("index", juce::String(chunk.index));
+    if (chunk.hostPosition)
+        url = url.withParameter("position", juce::String(*chunk.hostPosition));
+    url = url.withPOSTData(audioData);
     
+    int statusCode = 0;
     std::unique_ptr<juce::InputStream> response(url.createInputStream(
         juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inAddress)
             .withExtraHeaders(headers)
             .withConnectionTimeoutMs(5000)
             .withNumRedirectsToFollow(0)
+            .withStatusCode(&statusCode)
     ));
 
-    if (response != nullptr)
+    if (response == nullptr)
     {
-        juce::String responseText = response->readEntireStreamAsString();
-        DBG("Upload response: " + responseText);
-        return true;
+        DBG("Failed to upload chunk");
+        return 0;
     }
 
-    DBG("Failed to upload chunk");
-    return false;
+    juce::String responseText = response->readEntireStreamAsString();
+    DBG("Upload response: " + responseText);
+    
+    // A checksum mismatch comes back as 400 and has to count as a failed upload
+    return statusCode;
 }
 
-bool NetworkClient::fetchRecordedTracks(juce::Array<juce::String>& trackList)
+bool NetworkClient::fetchTrackChanges(juce::int64 sinceCursor, int limit, TrackChanges& changes)
 {
     if (apiUrl.isEmpty())
         return false;
 
-    juce::URL url(apiUrl + "/api/tracks");
+    juce::URL url(apiUrl + "/api/tracks/changes");
+    url = url.withParameter("since", juce::String(sinceCursor))
+             .withParameter("limit", juce::String(limit));
     
     juce::String headers;
     headers << "Authorization: " << getAuthHeader() << "\r\n";
 
+    int statusCode = 0;
+
     std::unique_ptr<juce::InputStream> response(url.createInputStream(
         juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inAddress)
             .withExtraHeaders(headers)
             .withConnectionTimeoutMs(5000)
+            .withStatusCode(&statusCode)
     ));
 
-    if (response != nullptr)
+    // Error bodies are JSON objects too, and mistaking one for an empty page
+    // would make the cache reset itself
+    if (response == nullptr || statusCode != 200)
+        return false;
+
+    juce::String responseText = response->readEntireStreamAsString();
+    
+    // Parse JSON response
+    juce::var json;
+    juce::Result result = juce::JSON::parse(responseText, json);
+    
+    if (result.wasOk() && json.isObject() && json.hasProperty("generation") && json.hasProperty("cursor"))
     {
-        juce::String responseText = response->readEntireStreamAsString();
-        
-        // Parse JSON response
-        juce::var json;
-        juce::Result result = juce::JSON::parse(responseText, json);
-        
-        if (result.wasOk() && json.isArray())
+        if (auto* tracks = json["tracks"].getArray())
         {
-            for (auto& track : *json.getArray())
+            for (auto& track : *tracks)
             {
-                if (track.hasProperty("id"))
-                    trackList.add(track["id"].toString());
+                if (!track.hasProperty("id"))
+                    continue;
+
+                TrackInfo info;
+                info.id = track["id"].toString();
+                info.name = track["name"].toString();
+                info.durationSeconds = static_cast<double>(track["duration"]);
+                info.sizeBytes = static_cast<juce::int64>(track["size"]);
+                info.etag = track["etag"].toString();
+                info.createdAt = track["created_at"].toString();
+
+                if (!track["host_start"].isVoid())
+                    info.hostStart = static_cast<juce::int64>(track["host_start"]);
+
+                changes.tracks.add(info);
             }
-            return true;
         }
+
+        if (auto* deleted = json["deleted"].getArray())
+        {
+            for (auto& trackId : *deleted)
+                changes.deletedIds.add(trackId.toString());
+        }
+
+        changes.generation = json["generation"].toString();
+        changes.cursor = static_cast<juce::int64>(json["cursor"]);
+        changes.hasMore = static_cast<bool>(json["has_more"]);
+        return true;
     }
 
     return false;
 }
 
-bool NetworkClient::downloadTrack(const juce::String& trackId, juce::MemoryBlock& audioData)
+bool NetworkClient::downloadTrack(const juce::String& trackId, const juce::File& destination, juce::String& etag)
 {
     if (apiUrl.isEmpty())
         return false;
@@ -222,26 +293,65 @@ bool NetworkClient::downloadTrack(const juce::String& trackId, juce::MemoryBlock
     juce::String headers;
     headers << "Authorization: " << getAuthHeader() << "\r\n";
 
+    juce::StringPairArray responseHeaders;
+    int statusCode = 0;
+
     std::unique_ptr<juce::InputStream> response(url.createInputStream(
         juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inAddress)
             .withExtraHeaders(headers)
             .withConnectionTimeoutMs(10000)
+            .withResponseHeaders(&responseHeaders)
+            .withStatusCode(&statusCode)
     ));
 
-    if (response != nullptr)
+    if (response == nullptr || statusCode != 200)
+        return false;
+
+    // Stream straight to a temporary file next to the destination so a
+    // half-finished download never shows up in the cache
+    destination.getParentDirectory().createDirectory();
+    juce::TemporaryFile tempFile(destination);
+    
     {
-        audioData.reset();
+        juce::FileOutputStream output(tempFile.getFile());
+        if (output.failedToOpen())
+            return false;
         
-        char buffer[8192];
-        while (!response->isExhausted())
-        {
-            auto bytesRead = response->read(buffer, sizeof(buffer));
-            if (bytesRead > 0)
-                audioData.append(buffer, static_cast<size_t>(bytesRead));
-        }
+        if (output.writeFromInputStream(*response, -1) <= 0)
+            return false;
         
-        return audioData.getSize() > 0;
+        output.flush();
+        if (output.getStatus().failed())
+            return false;
     }
 
-    return false;
+    etag = responseHeaders.getValue("ETag", {}).unquoted();
+    return tempFile.overwriteTargetFileWithTemporary();
+}
+
+bool NetworkClient::fetchTrackPeaks(const juce::String& trackId, juce::MemoryBlock& peakData)
+{
+    if (apiUrl.isEmpty())
+        return false;
+
+    juce::URL url(apiUrl + "/api/tracks/" + trackId + "/peaks");
+    
+    juce::String headers;
+    headers << "Authorization: " << getAuthHeader() << "\r\n";
+
+    int statusCode = 0;
+
+    std::unique_ptr<juce::InputStream> response(url.createInputStream(
+        juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inAddress)
+            .withExtraHeaders(headers)
+            .withConnectionTimeoutMs(5000)
+            .withStatusCode(&statusCode)
+    ));
+
+    if (response == nullptr || statusCode != 200)
+        return false;
+
+    peakData.reset();
+    response->readIntoMemoryBlock(peakData);
+    return peakData.getSize() > 0;
 }
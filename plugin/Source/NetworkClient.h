@@ -2,6 +2,44 @@
 
 #include <JuceHeader.h>
 
+struct TrackInfo
+{
+    juce::String id;
+    juce::String name;
+    double durationSeconds = 0.0;
+    juce::int64 sizeBytes = 0;
+    juce::String etag;
+    juce::String createdAt;
+    juce::Optional<juce::int64> hostStart;  // host timeline sample of the take's first frame, if recorded while playing
+};
+
+struct TrackChanges
+{
+    juce::Array<TrackInfo> tracks;
+    juce::StringArray deletedIds;
+    juce::String generation;
+    juce::int64 cursor = 0;
+    bool hasMore = false;
+};
+
+// Where an uploaded chunk belongs and what it should hash to
+struct ChunkInfo
+{
+    int take = 0;
+    int index = 0;  // orders the chunk within its take
+    juce::Optional<juce::int64> hostPosition;  // of the first frame, if known
+    juce::uint32 crc32 = 0;  // of the encoded bytes, checked by the backend on receipt
+};
+
+// One track created by finalizing a session
+struct FinalizedTake
+{
+    int take = 0;
+    juce::String trackId;
+    int numChunks = 0;
+    juce::uint32 chunkHash = 0;  // CRC-32 over the chunk CRCs the backend assembled, in order
+};
+
 class NetworkClient
 {
 public:
@@ -12,11 +50,17 @@ public:
     void setAuthentication(const juce::String& username, const juce::String& password);
     
     bool testConnection();
+    // Makes the cheapest authenticated request. Returns the HTTP status (200
+    // for accepted credentials, 401 for wrong ones), or 0 if unreachable.
+    int checkCredentials();
     juce::String startSession();
-    bool finalizeSession(const juce::String& sessionId);
-    bool sendAudioChunk(const juce::MemoryBlock& audioData, const juce::String& sessionId);
-    bool fetchRecordedTracks(juce::Array<juce::String>& trackList);
-    bool downloadTrack(const juce::String& trackId, juce::MemoryBlock& audioData);
+    bool finalizeSession(const juce::String& sessionId, juce::Array<FinalizedTake>& takes);
+    // Safe to call from several threads. Returns the HTTP status, or 0 if the
+    // server couldn't be reached.
+    int sendAudioChunk(const juce::MemoryBlock& audioData, const juce::String& sessionId, const ChunkInfo& chunk);
+    bool fetchTrackChanges(juce::int64 sinceCursor, int limit, TrackChanges& changes);
+    bool downloadTrack(const juce::String& trackId, const juce::File& destination, juce::String& etag);
+    bool fetchTrackPeaks(const juce::String& trackId, juce::MemoryBlock& peakData);
 
 private:
     juce::String getAuthHeader() const;
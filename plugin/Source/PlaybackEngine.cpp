@@ -0,0 +1,410 @@
+#include "PlaybackEngine.h"
+
+namespace
+{
+    constexpr double readAheadSeconds = 2.0;
+    constexpr juce::int64 pageSizeBytes = 4096;
+
+    // Replaced sources stay mapped this long so the audio and read-ahead
+    // threads can finish whatever block they were in the middle of
+    constexpr juce::uint32 retireGracePeriodMs = 2000;
+    constexpr int garbageCheckIntervalMs = 500;
+
+    constexpr double crossfadeSeconds = 0.02;
+    constexpr double levelRampSeconds = 0.05;
+}
+
+PlaybackEngine::PlaybackEngine()
+    : juce::Thread("Auxlee Read-Ahead")
+{
+}
+
+PlaybackEngine::~PlaybackEngine()
+{
+    stopTimer();
+    stopThread(1000);
+}
+
+void PlaybackEngine::prepare(double sampleRate, int blockSize, int numChannels)
+{
+    currentSampleRate = sampleRate;
+
+    // Larger host blocks are rendered in slices of this size
+    voiceBuffer.setSize(juce::jmax(1, numChannels), juce::jmax(1, blockSize));
+
+    incomingVoice.gain.reset(sampleRate, crossfadeSeconds);
+    outgoingVoice.gain.reset(sampleRate, crossfadeSeconds);
+    playbackGain.reset(sampleRate, levelRampSeconds);
+    playbackGain.setCurrentAndTargetValue(playbackLevel.load());
+    inputGain.reset(sampleRate, levelRampSeconds);
+    inputGain.setCurrentAndTargetValue(inputLevel.load());
+}
+
+bool PlaybackEngine::load(const juce::File& file)
+{
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(wavFormat.createMemoryMappedReader(file));
+
+    if (reader == nullptr || !reader->mapEntireFile() || reader->getMappedSection().isEmpty())
+    {
+        DBG("Failed to map " + file.getFullPathName());
+        return false;
+    }
+
+    DBG("Mapped WAV: " + juce::String(reader->lengthInSamples) + " samples, " +
+        juce::String(reader->numChannels) + " channels, " +
+        juce::String(reader->sampleRate) + " Hz");
+
+    static std::atomic<juce::uint32> nextSerial{ 1 };
+
+    auto source = std::make_unique<Source>();
+    source->reader = std::move(reader);
+    source->serial = nextSerial++;
+
+    // Publish the new source; the old one is retired rather than deleted
+    // because the other threads may still be reading from it
+    activeSource = source.get();
+
+    if (currentSource != nullptr)
+    {
+        currentSource->retiredAtMs = juce::Time::getMillisecondCounter();
+        retiredSources.add(currentSource.release());
+        startTimer(garbageCheckIntervalMs);
+    }
+
+    currentSource = std::move(source);
+    playing = true;
+
+    if (!isThreadRunning())
+        startThread();
+
+    return true;
+}
+
+double PlaybackEngine::getTrackSampleRate() const
+{
+    return currentSource != nullptr ? currentSource->reader->sampleRate : 0.0;
+}
+
+juce::Array<juce::File> PlaybackEngine::getMappedFiles() const
+{
+    juce::Array<juce::File> files;
+
+    if (currentSource != nullptr)
+        files.add(currentSource->reader->getFile());
+
+    for (auto* source : retiredSources)
+        files.add(source->reader->getFile());
+
+    return files;
+}
+
+void PlaybackEngine::stop()
+{
+    playing = false;
+}
+
+void PlaybackEngine::timerCallback()
+{
+    auto numRetired = retiredSources.size();
+    collectGarbage();
+
+    if (retiredSources.isEmpty())
+        stopTimer();
+
+    if (retiredSources.size() < numRetired && onSourcesReleased != nullptr)
+        onSourcesReleased();
+}
+
+void PlaybackEngine::collectGarbage()
+{
+    auto now = juce::Time::getMillisecondCounter();
+
+    auto oldestInUse = oldestSerialInUse.load();
+
+    for (int i = retiredSources.size(); --i >= 0;)
+    {
+        auto* source = retiredSources.getUnchecked(i);
+
+        // Still fading out on the audio thread, however long ago it was replaced
+        if (source->serial >= oldestInUse)
+            continue;
+
+        if (now - source->retiredAtMs > retireGracePeriodMs)
+            retiredSources.remove(i);
+    }
+}
+
+void PlaybackEngine::seek(juce::int64 samplePosition)
+{
+    pendingSeek = juce::jmax(static_cast<juce::int64>(0), samplePosition);
+}
+
+void PlaybackEngine::setFollowHostTransport(bool shouldFollow)
+{
+    followHostTransport = shouldFollow;
+}
+
+void PlaybackEngine::setHostStartPosition(juce::int64 hostSample)
+{
+    hostStartPosition = hostSample;
+}
+
+void PlaybackEngine::setLooping(bool shouldLoop)
+{
+    looping = shouldLoop;
+}
+
+void PlaybackEngine::setLoopRegion(juce::Range<juce::int64> region)
+{
+    // Odd version while the pair is being written
+    ++loopVersion;
+    loopStart = region.getStart();
+    loopEnd = region.getEnd();
+    ++loopVersion;
+}
+
+juce::Range<juce::int64> PlaybackEngine::readLoopRegion() const
+{
+    for (int attempt = 0; attempt < 4; ++attempt)
+    {
+        auto version = loopVersion.load();
+        if ((version & 1) != 0)
+            continue;
+
+        juce::Range<juce::int64> region(loopStart.load(), loopEnd.load());
+
+        if (loopVersion.load() == version)
+            return region;
+    }
+
+    return {};
+}
+
+bool PlaybackEngine::renderVoice(Voice& voice, int numSamples, juce::Range<juce::int64> loopRegion, bool loop)
+{
+    voiceBuffer.clear(0, numSamples);
+
+    auto& reader = *voice.source->reader;
+    juce::Range<juce::int64> takeRange(0, reader.lengthInSamples);
+
+    if (loop && loopRegion.isEmpty())
+        loopRegion = takeRange;
+
+    loopRegion = loopRegion.getIntersectionWith(takeRange);
+    bool loopActive = loop && !loopRegion.isEmpty();
+
+    constexpr int maxChannels = 8;
+    float* destChannels[maxChannels];
+    auto numChannels = juce::jmin(voiceBuffer.getNumChannels(), static_cast<int>(reader.numChannels), maxChannels);
+
+    int done = 0;
+    bool reachedEnd = false;
+
+    while (done < numSamples)
+    {
+        // Past the loop end (including after a host jump): wrap back inside the region
+        if (loopActive && voice.position >= loopRegion.getEnd())
+            voice.position = loopRegion.getStart() + (voice.position - loopRegion.getStart()) % loopRegion.getLength();
+
+        // Host is before the take starts; stay silent until it begins
+        if (voice.position < 0)
+        {
+            auto gap = static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamples - done), -voice.position));
+            voice.position += gap;
+            done += gap;
+            continue;
+        }
+
+        auto segmentEnd = loopActive ? loopRegion.getEnd() : reader.lengthInSamples;
+        auto segmentLength = static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamples - done),
+                                                         segmentEnd - voice.position));
+
+        if (segmentLength <= 0)
+        {
+            reachedEnd = true;
+            break;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            destChannels[channel] = voiceBuffer.getWritePointer(channel, done);
+
+        // Reads and converts straight from the mapped file; no allocation
+        reader.read(destChannels, numChannels, voice.position, segmentLength);
+
+        voice.position += segmentLength;
+        done += segmentLength;
+    }
+
+    // Mono takes play on every output channel
+    if (reader.numChannels == 1)
+    {
+        for (int channel = 1; channel < voiceBuffer.getNumChannels(); ++channel)
+            voiceBuffer.copyFrom(channel, 0, voiceBuffer, 0, 0, numSamples);
+    }
+
+    return !reachedEnd;
+}
+
+void PlaybackEngine::process(juce::AudioBuffer<float>& buffer, juce::AudioPlayHead* playHead)
+{
+    auto* source = activeSource.load();
+
+    // A new take: the current one becomes the outgoing voice and fades out as the new one fades in
+    if (source != nullptr && (incomingVoice.source == nullptr || incomingVoice.source->serial != source->serial))
+    {
+        outgoingVoice.source = incomingVoice.source;
+        outgoingVoice.position = incomingVoice.position;
+        outgoingVoice.gain.setCurrentAndTargetValue(incomingVoice.gain.getCurrentValue());
+        outgoingVoice.gain.setTargetValue(0.0f);
+
+        incomingVoice.source = source;
+        incomingVoice.position = 0;
+        incomingVoice.gain.setCurrentAndTargetValue(0.0f);
+    }
+
+    // Explicit seeks crossfade too, from the old position of the same take
+    auto seekPosition = pendingSeek.exchange(-1);
+    if (seekPosition >= 0 && incomingVoice.source != nullptr)
+    {
+        outgoingVoice.source = incomingVoice.source;
+        outgoingVoice.position = incomingVoice.position;
+        outgoingVoice.gain.setCurrentAndTargetValue(incomingVoice.gain.getCurrentValue());
+        outgoingVoice.gain.setTargetValue(0.0f);
+
+        incomingVoice.position = seekPosition;
+        incomingVoice.gain.setCurrentAndTargetValue(0.0f);
+    }
+
+    bool followHost = followHostTransport.load();
+    bool hostPlaying = true;
+
+    if (followHost)
+    {
+        // The host timeline is the only clock; a stopped transport fades out
+        hostPlaying = false;
+
+        if (playHead != nullptr)
+        {
+            auto info = playHead->getPosition();
+            if (info.hasValue() && info->getIsPlaying() && info->getTimeInSamples().hasValue())
+            {
+                auto hostPosition = *info->getTimeInSamples() - hostStartPosition.load();
+                hostPlaying = true;
+                incomingVoice.position = hostPosition;
+                outgoingVoice.position = hostPosition;
+            }
+        }
+    }
+
+    incomingVoice.gain.setTargetValue(playing.load() && hostPlaying ? 1.0f : 0.0f);
+    playbackGain.setTargetValue(playbackLevel.load());
+    inputGain.setTargetValue(inputLevel.load());
+
+    bool loop = looping.load();
+    auto loopRegion = loop ? readLoopRegion() : juce::Range<juce::int64>();
+
+    for (int offset = 0; offset < buffer.getNumSamples();)
+    {
+        auto numSamples = juce::jmin(buffer.getNumSamples() - offset, voiceBuffer.getNumSamples());
+
+        // Pass-through input, only touched when its level is not unity
+        auto inputStart = inputGain.getCurrentValue();
+        inputGain.skip(numSamples);
+        auto inputEnd = inputGain.getCurrentValue();
+
+        if (inputStart != 1.0f || inputEnd != 1.0f)
+            buffer.applyGainRamp(offset, numSamples, inputStart, inputEnd);
+
+        auto playbackStart = playbackGain.getCurrentValue();
+        playbackGain.skip(numSamples);
+        auto playbackEnd = playbackGain.getCurrentValue();
+
+        for (auto* voice : { &incomingVoice, &outgoingVoice })
+        {
+            if (voice->source == nullptr)
+                continue;
+
+            // Fully faded out: nothing to render
+            if (!voice->gain.isSmoothing() && voice->gain.getTargetValue() == 0.0f)
+            {
+                if (voice == &outgoingVoice)
+                    voice->source = nullptr;
+                continue;
+            }
+
+            auto voiceStart = voice->gain.getCurrentValue();
+            voice->gain.skip(numSamples);
+            auto voiceEnd = voice->gain.getCurrentValue();
+
+            if (!renderVoice(*voice, numSamples, loopRegion, loop))
+            {
+                // Free-running playback stops at the end; following the host just waits for it to come back
+                if (voice == &incomingVoice && !followHost)
+                {
+                    playing = false;
+                    voice->position = 0;
+                    voice->gain.setCurrentAndTargetValue(0.0f);
+                }
+            }
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            {
+                auto sourceChannel = juce::jmin(channel, voiceBuffer.getNumChannels() - 1);
+                buffer.addFromWithRamp(channel, offset, voiceBuffer.getReadPointer(sourceChannel), numSamples,
+                                       voiceStart * playbackStart, voiceEnd * playbackEnd);
+            }
+        }
+
+        offset += numSamples;
+    }
+
+    publishedPosition = incomingVoice.position;
+
+    // Lets the message thread know which retired sources are safe to free
+    auto oldestInUse = std::numeric_limits<juce::uint32>::max();
+    for (auto* voice : { &incomingVoice, &outgoingVoice })
+    {
+        if (voice->source != nullptr)
+            oldestInUse = juce::jmin(oldestInUse, voice->source->serial);
+    }
+
+    oldestSerialInUse = oldestInUse;
+}
+
+void PlaybackEngine::run()
+{
+    Source* touchedSource = nullptr;
+    juce::int64 touchedFrom = 0;
+    juce::int64 touchedUpTo = 0;
+
+    while (!threadShouldExit())
+    {
+        auto* source = activeSource.load();
+
+        if (source != nullptr && playing.load())
+        {
+            auto& reader = *source->reader;
+            auto position = publishedPosition.load();
+
+            // Start over after a track change or when the cursor left the touched range
+            if (source != touchedSource || position < touchedFrom || position > touchedUpTo)
+            {
+                touchedSource = source;
+                touchedFrom = position;
+                touchedUpTo = position;
+            }
+
+            auto bytesPerFrame = juce::jmax(1, static_cast<int>(reader.numChannels * reader.bitsPerSample / 8));
+            auto framesPerPage = juce::jmax(static_cast<juce::int64>(1), pageSizeBytes / bytesPerFrame);
+            auto readAheadEnd = juce::jmin(reader.lengthInSamples,
+                                           position + static_cast<juce::int64>(readAheadSeconds * currentSampleRate.load()));
+
+            // Fault in every page between what we've already touched and the read-ahead horizon
+            for (; touchedUpTo < readAheadEnd; touchedUpTo += framesPerPage)
+                reader.touchSample(touchedUpTo);
+        }
+
+        wait(20);
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Plays a track straight out of a memory-mapped WAV file. Nothing is decoded
+// up front; a background thread touches the pages just ahead of the play
+// cursor so the audio thread rarely has to wait on the disk.
+//
+// Either free-runs from wherever it was started, or follows the host
+// transport so the take plays in sync with the DAW timeline. Control
+// methods only store atomics; the audio thread never locks or allocates.
+//
+// Playback is mixed on top of the incoming signal rather than replacing it.
+// Switching takes crossfades the outgoing and incoming take, and level
+// changes are ramped, so neither produces a click.
+//
+// A replaced take stays mapped until the other threads are done with it; a
+// message-thread timer unmaps it and then reports it through onSourcesReleased.
+class PlaybackEngine : private juce::Thread,
+                       private juce::Timer
+{
+public:
+    PlaybackEngine();
+    ~PlaybackEngine() override;
+
+    void prepare(double sampleRate, int blockSize, int numChannels);
+
+    // Message thread
+    bool load(const juce::File& file);
+    void stop();
+    bool isPlaying() const { return playing.load(); }
+    void seek(juce::int64 samplePosition);
+    juce::int64 getPosition() const { return publishedPosition.load(); }
+    // Of the loaded take; 0 when nothing is loaded
+    double getTrackSampleRate() const;
+    // The loaded take and any replaced ones that are still mapped
+    juce::Array<juce::File> getMappedFiles() const;
+    // Called once replaced takes have been unmapped
+    std::function<void()> onSourcesReleased;
+
+    // When following the host, sample 0 of the take lines up with this
+    // host timeline position and playback starts/stops/seeks with the DAW
+    void setFollowHostTransport(bool shouldFollow);
+    bool isFollowingHostTransport() const { return followHostTransport.load(); }
+    void setHostStartPosition(juce::int64 hostSample);
+
+    // An empty range loops the whole take
+    void setLooping(bool shouldLoop);
+    bool isLooping() const { return looping.load(); }
+    void setLoopRegion(juce::Range<juce::int64> region);
+
+    // Linear gains for the playback and for the pass-through input
+    void setPlaybackLevel(float newLevel) { playbackLevel = newLevel; }
+    float getPlaybackLevel() const { return playbackLevel.load(); }
+    void setInputLevel(float newLevel) { inputLevel = newLevel; }
+    float getInputLevel() const { return inputLevel.load(); }
+
+    // Audio thread; mixes playback into the buffer on top of the input
+    void process(juce::AudioBuffer<float>& buffer, juce::AudioPlayHead* playHead);
+
+private:
+    struct Source
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+        juce::uint32 serial = 0;
+        juce::uint32 retiredAtMs = 0;
+    };
+
+    // One take being rendered; a second voice carries the outgoing take during a crossfade
+    struct Voice
+    {
+        Source* source = nullptr;
+        juce::int64 position = 0;
+        juce::SmoothedValue<float> gain;
+    };
+
+    void run() override;
+    void timerCallback() override;
+    void collectGarbage();
+    juce::Range<juce::int64> readLoopRegion() const;
+    // Renders the next block of a voice into voiceBuffer; false once the take has run out
+    bool renderVoice(Voice& voice, int numSamples, juce::Range<juce::int64> loopRegion, bool loop);
+
+    std::unique_ptr<Source> currentSource;
+    juce::OwnedArray<Source> retiredSources;
+    std::atomic<Source*> activeSource{ nullptr };
+    std::atomic<juce::uint32> oldestSerialInUse{ std::numeric_limits<juce::uint32>::max() };
+
+    std::atomic<bool> playing{ false };
+    std::atomic<bool> followHostTransport{ false };
+    std::atomic<juce::int64> hostStartPosition{ 0 };
+    std::atomic<juce::int64> pendingSeek{ -1 };
+    std::atomic<juce::int64> publishedPosition{ 0 };
+
+    // Written as a pair; the version lets the audio thread detect a torn read
+    std::atomic<bool> looping{ false };
+    std::atomic<juce::int64> loopStart{ 0 };
+    std::atomic<juce::int64> loopEnd{ 0 };
+    std::atomic<juce::uint32> loopVersion{ 0 };
+
+    std::atomic<float> playbackLevel{ 1.0f };
+    std::atomic<float> inputLevel{ 1.0f };
+
+    // Audio thread only
+    Voice incomingVoice;
+    Voice outgoingVoice;
+    juce::SmoothedValue<float> playbackGain;
+    juce::SmoothedValue<float> inputGain;
+    juce::AudioBuffer<float> voiceBuffer;
+
+    std::atomic<double> currentSampleRate{ 44100.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlaybackEngine)
+};
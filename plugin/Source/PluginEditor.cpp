@@ -1,25 +1,47 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    // Stacked input meters; the window height is set around them
+    constexpr int inputMeterHeight = 10;
+    constexpr int inputMeterGap = 2;
+    constexpr int heightWithoutInputMeters = 983;
+
+    int inputMeterRowHeight(int numMeters)
+    {
+        return numMeters * inputMeterHeight + (numMeters - 1) * inputMeterGap;
+    }
+}
+
 AuxleeAudioProcessorEditor::AuxleeAudioProcessorEditor(AuxleeAudioProcessor& p)
     : AudioProcessorEditor(&p), audioProcessor(p)
 {
-    setSize(400, 550);
+    setSize(400, heightWithoutInputMeters + inputMeterRowHeight(2));
 
     // API URL
     apiUrlLabel.setText("API URL:", juce::dontSendNotification);
     apiUrlLabel.setJustificationType(juce::Justification::right);
     addAndMakeVisible(apiUrlLabel);
 
-    apiUrlEditor.setText("http://localhost:8000");
+    apiUrlEditor.setText(audioProcessor.getApiUrl().isNotEmpty() ? audioProcessor.getApiUrl() : "http://localhost:8000");
     addAndMakeVisible(apiUrlEditor);
 
+    // Optional second server that receives every chunk too
+    backupUrlLabel.setText("Backup URL:", juce::dontSendNotification);
+    backupUrlLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(backupUrlLabel);
+
+    backupUrlEditor.setText(audioProcessor.getBackupApiUrl());
+    backupUrlEditor.setTextToShowWhenEmpty("(none)", juce::Colours::grey);
+    addAndMakeVisible(backupUrlEditor);
+
     // Username
     usernameLabel.setText("Username:", juce::dontSendNotification);
     usernameLabel.setJustificationType(juce::Justification::right);
     addAndMakeVisible(usernameLabel);
 
-    usernameEditor.setText("admin");
+    usernameEditor.setText(audioProcessor.getAuthUsername().isNotEmpty() ? audioProcessor.getAuthUsername() : "admin");
     addAndMakeVisible(usernameEditor);
 
     // Password
@@ -35,42 +57,16 @@ AuxleeAudioProcessorEditor::AuxleeAudioProcessorEditor(AuxleeAudioProcessor& p)
     connectButton.setButtonText("Connect");
     connectButton.onClick = [this]
     {
-        // Change button text immediately to prove onClick is firing
-        connectButton.setButtonText("CLICKED!");
-        
-        auto url = apiUrlEditor.getText();
-        auto username = usernameEditor.getText();
-        auto password = passwordEditor.getText();
-        
-        // Set the credentials in the processor
-        audioProcessor.setApiUrl(url);
-        audioProcessor.setAuthentication(username, password);
+        audioProcessor.setApiUrl(apiUrlEditor.getText());
+        audioProcessor.setBackupApiUrl(backupUrlEditor.getText().trim());
+        audioProcessor.setAuthentication(usernameEditor.getText(), passwordEditor.getText());
         
-        // Update status with forced notification
-        juce::MessageManager::callAsync([this, url]()
-        {
-            statusLabel.setText("✓ CONNECTED: " + url, juce::sendNotification);
-            statusLabel.setColour(juce::Label::textColourId, juce::Colours::white);
-            statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::green);
-            
-            // Hide login form
-            apiUrlLabel.setVisible(false);
-            apiUrlEditor.setVisible(false);
-            usernameLabel.setVisible(false);
-            usernameEditor.setVisible(false);
-            passwordLabel.setVisible(false);
-            passwordEditor.setVisible(false);
-            connectButton.setVisible(false);
-            
-            // Show track management UI
-            tracksLabel.setVisible(true);
-            trackSelector.setVisible(true);
-            refreshTracksButton.setVisible(true);
-            loadTrackButton.setVisible(true);
-            
-            // Load initial track list
-            refreshTrackList();
-        });
+        // Checked and synced on the warm-up thread; timerCallback shows the outcome
+        audioProcessor.refreshConnection();
+        reportConnection = true;
+        connectButton.setEnabled(false);
+        statusLabel.setText("Connecting...", juce::sendNotification);
+        statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::blue);
     };
     addAndMakeVisible(connectButton);
 
@@ -81,32 +77,44 @@ AuxleeAudioProcessorEditor::AuxleeAudioProcessorEditor(AuxleeAudioProcessor& p)
     {
         DBG("=== Record button clicked ===");
         
-        bool currentlyRecording = audioProcessor.isRecording();
-        audioProcessor.setRecording(!currentlyRecording);
-        
-        if (!currentlyRecording)
-        {
-            recordButton.setButtonText("Stop Recording");
-            recordButton.setColour(juce::TextButton::buttonColourId, juce::Colours::red);
-            statusLabel.setText("🔴 RECORDING...", juce::sendNotification);
-            statusLabel.setColour(juce::Label::textColourId, juce::Colours::white);
-            statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::red);
-            DBG("Started recording");
-        }
-        else
+        // Takes after the first only flip local state, so rapid start/stop is instant
+        audioProcessor.setRecording(!audioProcessor.isRecording());
+        updateRecordingStatus();
+    };
+    addAndMakeVisible(recordButton);
+    
+    finishSessionButton.setButtonText("Finish Session");
+    finishSessionButton.setEnabled(false);
+    finishSessionButton.onClick = [this]
+    {
+        // Waits on the uploads and every server's assembly, so the result comes back later
+        audioProcessor.finishSessionAsync([editor = juce::Component::SafePointer<AuxleeAudioProcessorEditor>(this)]
+                                          (bool finished, int unverifiedTakes, const juce::String& verifiedOn)
         {
-            recordButton.setButtonText("Start Recording");
-            recordButton.setColour(juce::TextButton::buttonColourId, juce::Colours::green);
-            statusLabel.setText("⏹ Stopped", juce::sendNotification);
-            statusLabel.setColour(juce::Label::textColourId, juce::Colours::white);
-            statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::orange);
-            DBG("Stopped recording");
-        }
+            if (editor != nullptr)
+                editor->showFinishedSession(finished, unverifiedTakes, verifiedOn);
+        });
         
-        recordButton.repaint();
-        statusLabel.repaint();
+        updateRecordingStatus();
     };
-    addAndMakeVisible(recordButton);
+    addAndMakeVisible(finishSessionButton);
+    
+    // Punch region, in seconds on the host timeline
+    punchButton.setButtonText("Punch (s):");
+    punchButton.setToggleState(audioProcessor.isPunchEnabled(), juce::dontSendNotification);
+    punchButton.onClick = [this] { applyPunchSettings(); };
+    addAndMakeVisible(punchButton);
+    
+    auto punchRegion = audioProcessor.getPunchRegion();
+    punchInEditor.setText(juce::String(punchRegion.getStart(), 2));
+    punchInEditor.setInputRestrictions(10, "0123456789.");
+    punchInEditor.onFocusLost = punchInEditor.onReturnKey = [this] { applyPunchSettings(); };
+    addAndMakeVisible(punchInEditor);
+    
+    punchOutEditor.setText(juce::String(punchRegion.getEnd(), 2));
+    punchOutEditor.setInputRestrictions(10, "0123456789.");
+    punchOutEditor.onFocusLost = punchOutEditor.onReturnKey = [this] { applyPunchSettings(); };
+    addAndMakeVisible(punchOutEditor);
 
     // Status label
     statusLabel.setText("Not connected", juce::dontSendNotification);
@@ -116,6 +124,79 @@ AuxleeAudioProcessorEditor::AuxleeAudioProcessorEditor(AuxleeAudioProcessor& p)
     statusLabel.setFont(juce::Font(16.0f, juce::Font::bold));
     addAndMakeVisible(statusLabel);
 
+    // Input meters and upload backlog
+    inputMeterLabel.setText("Input:", juce::dontSendNotification);
+    inputMeterLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(inputMeterLabel);
+    
+    // Only as many as the input bus has channels are shown
+    for (auto& meter : inputMeters)
+        addChildComponent(meter);
+    
+    backlogLabel.setText("Backlog:", juce::dontSendNotification);
+    backlogLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(backlogLabel);
+    
+    backlogMeter.setBarColour(juce::Colours::orange);
+    addAndMakeVisible(backlogMeter);
+    
+    streamStatsLabel.setJustificationType(juce::Justification::centred);
+    streamStatsLabel.setFont(juce::Font(12.0f));
+    addAndMakeVisible(streamStatsLabel);
+    
+    // Lossy upload for slow connections; item IDs are the bitrate, lossless
+    // formats use 1 + their SampleFormat value
+    uploadQualityLabel.setText("Upload:", juce::dontSendNotification);
+    uploadQualityLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(uploadQualityLabel);
+    
+    uploadQualitySelector.addItem("WAV 16-bit", 1 + static_cast<int>(AudioStreamer::SampleFormat::int16));
+    uploadQualitySelector.addItem("WAV 24-bit", 1 + static_cast<int>(AudioStreamer::SampleFormat::int24));
+    uploadQualitySelector.addItem("WAV 32-bit float", 1 + static_cast<int>(AudioStreamer::SampleFormat::float32));
+    for (int kbps : { 64, 96, 128, 192 })
+        uploadQualitySelector.addItem("Ogg Vorbis " + juce::String(kbps) + " kbps", kbps);
+    
+    auto bitrate = audioProcessor.getUploadBitrateKbps();
+    uploadQualitySelector.setSelectedId(bitrate > 0 ? bitrate : 1 + static_cast<int>(audioProcessor.getUploadSampleFormat()),
+                                        juce::dontSendNotification);
+    uploadQualitySelector.onChange = [this]
+    {
+        auto selected = uploadQualitySelector.getSelectedId();
+        if (selected <= SampleKernels::numFormats)
+        {
+            audioProcessor.setUploadSampleFormat(static_cast<AudioStreamer::SampleFormat>(selected - 1));
+            audioProcessor.setUploadBitrateKbps(0);
+        }
+        else
+        {
+            audioProcessor.setUploadBitrateKbps(selected);
+        }
+    };
+    addAndMakeVisible(uploadQualitySelector);
+    
+    localCopyButton.setButtonText("Keep local copy");
+    localCopyButton.setToggleState(audioProcessor.keepsLocalCopy(), juce::dontSendNotification);
+    localCopyButton.onClick = [this] { audioProcessor.setKeepLocalCopy(localCopyButton.getToggleState()); };
+    addAndMakeVisible(localCopyButton);
+    
+    // Bandwidth cap for uploads; item IDs are the rate in kbps, 1 is unlimited
+    uploadLimitLabel.setText("Limit:", juce::dontSendNotification);
+    uploadLimitLabel.setJustificationType(juce::Justification::right);
+    addAndMakeVisible(uploadLimitLabel);
+    
+    uploadLimitSelector.addItem("Unlimited", 1);
+    for (int kbps : { 256, 512, 1000, 2000, 5000, 10000 })
+        uploadLimitSelector.addItem(kbps < 1000 ? juce::String(kbps) + " kbps" : juce::String(kbps / 1000) + " Mbps", kbps);
+    
+    auto limit = audioProcessor.getUploadRateLimitKbps();
+    uploadLimitSelector.setSelectedId(limit > 0 ? limit : 1, juce::dontSendNotification);
+    uploadLimitSelector.onChange = [this]
+    {
+        auto selected = uploadLimitSelector.getSelectedId();
+        audioProcessor.setUploadRateLimitKbps(selected > 1 ? selected : 0);
+    };
+    addAndMakeVisible(uploadLimitSelector);
+
     // Track management UI (initially hidden)
     tracksLabel.setText("Available Tracks:", juce::dontSendNotification);
     tracksLabel.setJustificationType(juce::Justification::left);
@@ -123,9 +204,19 @@ AuxleeAudioProcessorEditor::AuxleeAudioProcessorEditor(AuxleeAudioProcessor& p)
     addAndMakeVisible(tracksLabel);
     
     trackSelector.setTextWhenNothingSelected("No tracks available");
+    trackSelector.onChange = [this] { showSelectedWaveform(); };
     trackSelector.setVisible(false);
     addAndMakeVisible(trackSelector);
     
+    waveformView.onSeek = [this](juce::int64 frame)
+    {
+        // The overview may show another track than the one playing
+        if (waveformTrackId == audioProcessor.getLoadedTrackId())
+            audioProcessor.seekPlayback(frame);
+    };
+    waveformView.setVisible(false);
+    addAndMakeVisible(waveformView);
+    
     refreshTracksButton.setButtonText("Refresh");
     refreshTracksButton.onClick = [this] { refreshTrackList(); };
     refreshTracksButton.setVisible(false);
@@ -136,7 +227,53 @@ AuxleeAudioProcessorEditor::AuxleeAudioProcessorEditor(AuxleeAudioProcessor& p)
     loadTrackButton.setEnabled(false);
     loadTrackButton.setVisible(false);
     addAndMakeVisible(loadTrackButton);
+    
+    followHostButton.setButtonText("Follow DAW transport");
+    followHostButton.setToggleState(audioProcessor.playbackFollowsHost(), juce::dontSendNotification);
+    followHostButton.onClick = [this] { audioProcessor.setPlaybackFollowsHost(followHostButton.getToggleState()); };
+    followHostButton.setVisible(false);
+    addAndMakeVisible(followHostButton);
+    
+    // Loop region in seconds from the start of the take; 0 - 0 loops the whole take
+    loopButton.setButtonText("Loop (s):");
+    loopButton.setToggleState(audioProcessor.isPlaybackLooping(), juce::dontSendNotification);
+    loopButton.onClick = [this] { audioProcessor.setPlaybackLooping(loopButton.getToggleState()); };
+    loopButton.setVisible(false);
+    addAndMakeVisible(loopButton);
+    
+    auto loopRegion = audioProcessor.getPlaybackLoopRegion();
+    loopStartEditor.setText(juce::String(loopRegion.getStart(), 2));
+    loopStartEditor.setInputRestrictions(10, "0123456789.");
+    loopStartEditor.onFocusLost = loopStartEditor.onReturnKey = [this] { applyLoopSettings(); };
+    loopStartEditor.setVisible(false);
+    addAndMakeVisible(loopStartEditor);
+    
+    loopEndEditor.setText(juce::String(loopRegion.getEnd(), 2));
+    loopEndEditor.setInputRestrictions(10, "0123456789.");
+    loopEndEditor.onFocusLost = loopEndEditor.onReturnKey = [this] { applyLoopSettings(); };
+    loopEndEditor.setVisible(false);
+    addAndMakeVisible(loopEndEditor);
+    
+    playbackLevelLabel.setText("Playback:", juce::dontSendNotification);
+    playbackLevelLabel.setJustificationType(juce::Justification::right);
+    playbackLevelLabel.setVisible(false);
+    addAndMakeVisible(playbackLevelLabel);
+    
+    playbackLevelSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    playbackLevelSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
+    playbackLevelSlider.setRange(0.0, 1.0, 0.01);
+    playbackLevelSlider.setValue(audioProcessor.getPlaybackLevel(), juce::dontSendNotification);
+    playbackLevelSlider.onValueChange = [this]
+    {
+        audioProcessor.setPlaybackLevel(static_cast<float>(playbackLevelSlider.getValue()));
+    };
+    playbackLevelSlider.setVisible(false);
+    addAndMakeVisible(playbackLevelSlider);
 
+    updateInputMeterCount();
+    
+    // Opens straight onto the track list when this or another instance is already signed in
+    updateConnectionStatus();
     startTimerHz(30);
 }
 
@@ -163,6 +300,11 @@ void AuxleeAudioProcessorEditor::resized()
     apiUrlEditor.setBounds(bounds.removeFromTop(25).reduced(5, 0));
     bounds.removeFromTop(10);
 
+    auto backupRow = bounds.removeFromTop(25);
+    backupUrlLabel.setBounds(backupRow.removeFromLeft(100));
+    backupUrlEditor.setBounds(backupRow.reduced(5, 0));
+    bounds.removeFromTop(10);
+
     usernameLabel.setBounds(bounds.removeFromTop(25).removeFromLeft(100));
     usernameEditor.setBounds(bounds.removeFromTop(25).reduced(5, 0));
     bounds.removeFromTop(10);
@@ -174,11 +316,52 @@ void AuxleeAudioProcessorEditor::resized()
     connectButton.setBounds(bounds.removeFromTop(30).reduced(80, 0));
     bounds.removeFromTop(15);
 
-    recordButton.setBounds(bounds.removeFromTop(40).reduced(60, 0));
-    bounds.removeFromTop(20);
+    auto recordRow = bounds.removeFromTop(40);
+    recordButton.setBounds(recordRow.removeFromLeft(recordRow.getWidth() / 2).reduced(5, 0));
+    finishSessionButton.setBounds(recordRow.reduced(5, 0));
+    bounds.removeFromTop(10);
+    
+    auto punchRow = bounds.removeFromTop(25);
+    punchButton.setBounds(punchRow.removeFromLeft(110));
+    punchInEditor.setBounds(punchRow.removeFromLeft(100).reduced(5, 0));
+    punchOutEditor.setBounds(punchRow.removeFromLeft(100).reduced(5, 0));
+    bounds.removeFromTop(15);
 
     statusLabel.setBounds(bounds.removeFromTop(50));
-    bounds.removeFromTop(15);
+    bounds.removeFromTop(10);
+    
+    auto numMeters = juce::jmax(1, shownMeterChannels);
+    auto meterRow = bounds.removeFromTop(inputMeterRowHeight(numMeters));
+    inputMeterLabel.setBounds(meterRow.removeFromLeft(70).removeFromTop(inputMeterRowHeight(2)));
+    meterRow.removeFromLeft(5);
+    
+    for (int channel = 0; channel < numMeters; ++channel)
+    {
+        inputMeters[channel].setBounds(meterRow.removeFromTop(inputMeterHeight));
+        meterRow.removeFromTop(inputMeterGap);
+    }
+    
+    bounds.removeFromTop(6);
+    
+    auto backlogRow = bounds.removeFromTop(12);
+    backlogLabel.setBounds(backlogRow.removeFromLeft(70));
+    backlogRow.removeFromLeft(5);
+    backlogMeter.setBounds(backlogRow);
+    streamStatsLabel.setBounds(bounds.removeFromTop(60));  // stats plus a line per sink
+    bounds.removeFromTop(5);
+    
+    auto uploadRow = bounds.removeFromTop(25);
+    uploadQualityLabel.setBounds(uploadRow.removeFromLeft(70));
+    uploadRow.removeFromLeft(5);
+    localCopyButton.setBounds(uploadRow.removeFromRight(130));
+    uploadQualitySelector.setBounds(uploadRow.withTrimmedRight(5));
+    bounds.removeFromTop(5);
+    
+    auto limitRow = bounds.removeFromTop(25);
+    uploadLimitLabel.setBounds(limitRow.removeFromLeft(70));
+    limitRow.removeFromLeft(5);
+    uploadLimitSelector.setBounds(limitRow.removeFromLeft(150));
+    bounds.removeFromTop(10);
     
     // Track management UI
     tracksLabel.setBounds(bounds.removeFromTop(25));
@@ -188,48 +371,339 @@ void AuxleeAudioProcessorEditor::resized()
     trackRow.removeFromLeft(10);
     refreshTracksButton.setBounds(trackRow.removeFromLeft(70));
     
+    bounds.removeFromTop(10);
+    waveformView.setBounds(bounds.removeFromTop(80));
+    
     bounds.removeFromTop(10);
     loadTrackButton.setBounds(bounds.removeFromTop(35).reduced(80, 0));
+    
+    bounds.removeFromTop(10);
+    followHostButton.setBounds(bounds.removeFromTop(30).removeFromLeft(200));
+    
+    bounds.removeFromTop(5);
+    auto loopRow = bounds.removeFromTop(25);
+    loopButton.setBounds(loopRow.removeFromLeft(110));
+    loopStartEditor.setBounds(loopRow.removeFromLeft(100).reduced(5, 0));
+    loopEndEditor.setBounds(loopRow.removeFromLeft(100).reduced(5, 0));
+    
+    bounds.removeFromTop(10);
+    auto levelRow = bounds.removeFromTop(30);
+    playbackLevelLabel.setBounds(levelRow.removeFromLeft(100));
+    playbackLevelSlider.setBounds(levelRow);
 }
 
 void AuxleeAudioProcessorEditor::timerCallback()
 {
-    // Update UI based on recording state
+    // Meters use a -60..0 dB scale
+    auto toMeter = [](float gain)
+    {
+        return juce::jmap(juce::Decibels::gainToDecibels(gain, -60.0f), -60.0f, 0.0f, 0.0f, 1.0f);
+    };
+    
+    // The host can change the layout while the editor is open
+    updateInputMeterCount();
+    
+    for (int channel = 0; channel < shownMeterChannels; ++channel)
+    {
+        // Hold peaks briefly, then let them fall back
+        auto peak = audioProcessor.takeInputPeak(channel);
+        displayedPeaks[channel] = juce::jmax(peak, displayedPeaks[channel] * 0.92f);
+        
+        inputMeters[channel].setLevels(toMeter(audioProcessor.getInputRms(channel)), toMeter(displayedPeaks[channel]));
+    }
+    
+    auto stats = audioProcessor.getStreamerStatistics();
+    backlogMeter.setLevels(stats.queueCapacity > 0 ? static_cast<float>(stats.queuedChunks) / stats.queueCapacity : 0.0f, 0.0f);
+    
+    juce::String text;
+    text << "Queue " << stats.queuedChunks << "/" << stats.queueCapacity
+         << "  lag " << juce::String(stats.uploadLagMs / 1000.0, 1) << "s"
+         << "  sent " << stats.chunksSent
+         << "  failed " << stats.chunksFailed
+         << "  " << stats.uploadKbps << " kbps"
+         << " (enc " << juce::String(stats.lastEncodeMs, 1) << "ms)";
+    
+    if (stats.droppedSamples > 0)
+        text << "  dropped " << stats.droppedSamples;
+    
+    // One line per destination while a session is open
+    for (auto& sink : stats.sinks)
+    {
+        text << "\n" << sink.name << (sink.healthy ? " ✓" : " ✗")
+             << "  queued " << sink.queuedChunks << "  sent " << sink.chunksSent;
+        
+        if (sink.backlogChunks > 0)
+            text << "  backlog " << sink.backlogChunks;
+        
+        if (sink.chunksDropped > 0)
+            text << "  lost " << sink.chunksDropped;
+    }
+    
+    streamStatsLabel.setText(text, juce::dontSendNotification);
+    
+    waveformView.setPlayPosition(waveformTrackId == audioProcessor.getLoadedTrackId() ? audioProcessor.getPlaybackPosition() : 0);
+    
+    if (audioProcessor.getConnectionState() != shownConnectionState
+        || audioProcessor.getTrackListRevision() != shownTrackListRevision)
+        updateConnectionStatus();
+}
+
+void AuxleeAudioProcessorEditor::updateInputMeterCount()
+{
+    auto numChannels = audioProcessor.getNumMeteredChannels();
+    if (numChannels == shownMeterChannels)
+        return;
+    
+    shownMeterChannels = numChannels;
+    
+    for (int channel = 0; channel < AuxleeAudioProcessor::maxChannels; ++channel)
+        inputMeters[channel].setVisible(channel < numChannels);
+    
+    // setSize() only lays out again when the height actually changes
+    auto height = heightWithoutInputMeters + inputMeterRowHeight(numChannels);
+    if (height != getHeight())
+        setSize(getWidth(), height);
+    else
+        resized();
 }
 
-void AuxleeAudioProcessorEditor::refreshTrackList()
+void AuxleeAudioProcessorEditor::updateConnectionStatus()
 {
-    trackSelector.clear();
-    trackIds.clear();
+    using State = ConnectionWarmup::State;
     
-    juce::Array<juce::String> trackList;
-    if (audioProcessor.fetchTracks(trackList))
+    auto state = audioProcessor.getConnectionState();
+    bool listReloaded = audioProcessor.getTrackListRevision() != shownTrackListRevision;
+    shownConnectionState = state;
+    shownTrackListRevision = audioProcessor.getTrackListRevision();
+    
+    connectButton.setEnabled(state != State::checking);
+    
+    // The cached list is there before sign-in, ready for when the track view shows
+    if (listReloaded)
+        populateTrackSelector();
+    
+    if (state == State::signedIn)
+        showConnectedLayout();
+    
+    // The label is shared with recording status, so background checks only
+    // take it over after Connect or Refresh was clicked
+    if (!reportConnection || state == State::idle)
+        return;
+    
+    auto colour = juce::Colours::red;
+    
+    switch (state)
     {
-        for (int i = 0; i < trackList.size(); ++i)
-        {
-            trackSelector.addItem("Track " + juce::String(i + 1), i + 1);
-            trackIds.add(trackList[i]);
-        }
-        
-        loadTrackButton.setEnabled(trackList.size() > 0);
-        
-        if (trackList.size() > 0)
-        {
-            trackSelector.setSelectedId(1);
-            statusLabel.setText("✓ Found " + juce::String(trackList.size()) + " track(s)", juce::sendNotification);
-            statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::green);
-        }
+        case State::checking:
+            statusLabel.setText("Connecting...", juce::sendNotification);
+            colour = juce::Colours::blue;
+            break;
+        case State::signedIn:
+            statusLabel.setText("✓ CONNECTED: " + audioProcessor.getApiUrl() + "\n"
+                                + (trackIds.isEmpty() ? "No tracks available" : juce::String(trackIds.size()) + " track(s)"),
+                                juce::sendNotification);
+            colour = juce::Colours::green;
+            break;
+        case State::reachable:
+            statusLabel.setText("Server found - enter your password", juce::sendNotification);
+            colour = juce::Colours::orange;
+            break;
+        case State::unreachable:
+            statusLabel.setText("Server unreachable", juce::sendNotification);
+            break;
+        case State::rejected:
+            statusLabel.setText("Wrong username or password", juce::sendNotification);
+            break;
+        case State::failed:
+        default:
+            statusLabel.setText("Sign-in check or track sync failed", juce::sendNotification);
+            break;
+    }
+    
+    statusLabel.setColour(juce::Label::textColourId, juce::Colours::white);
+    statusLabel.setColour(juce::Label::backgroundColourId, colour);
+    
+    if (state != State::checking)
+        reportConnection = false;
+}
+
+void AuxleeAudioProcessorEditor::showConnectedLayout()
+{
+    // Hide login form
+    apiUrlLabel.setVisible(false);
+    apiUrlEditor.setVisible(false);
+    backupUrlLabel.setVisible(false);
+    backupUrlEditor.setVisible(false);
+    usernameLabel.setVisible(false);
+    usernameEditor.setVisible(false);
+    passwordLabel.setVisible(false);
+    passwordEditor.setVisible(false);
+    connectButton.setVisible(false);
+    
+    // Show track management UI
+    tracksLabel.setVisible(true);
+    trackSelector.setVisible(true);
+    waveformView.setVisible(true);
+    refreshTracksButton.setVisible(true);
+    loadTrackButton.setVisible(true);
+    followHostButton.setVisible(true);
+    loopButton.setVisible(true);
+    loopStartEditor.setVisible(true);
+    loopEndEditor.setVisible(true);
+    playbackLevelLabel.setVisible(true);
+    playbackLevelSlider.setVisible(true);
+}
+
+void AuxleeAudioProcessorEditor::updateRecordingStatus()
+{
+    auto recording = audioProcessor.isRecording();
+    
+    recordButton.setButtonText(recording ? "Stop Recording" : "Start Recording");
+    recordButton.setColour(juce::TextButton::buttonColourId, recording ? juce::Colours::red : juce::Colours::green);
+    recordButton.setEnabled(!audioProcessor.isFinishingSession());
+    finishSessionButton.setEnabled(audioProcessor.hasOpenSession() && !audioProcessor.isFinishingSession());
+    
+    if (audioProcessor.isFinishingSession())
+    {
+        statusLabel.setText("Assembling takes...", juce::sendNotification);
+        statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::blue);
+    }
+    else if (recording)
+    {
+        if (audioProcessor.isPunchEnabled())
+            statusLabel.setText("🔴 ARMED - punch in at " + punchInEditor.getText() + "s", juce::sendNotification);
         else
-        {
-            statusLabel.setText("No tracks available", juce::sendNotification);
-            statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::orange);
-        }
+            statusLabel.setText("🔴 RECORDING take " + juce::String(audioProcessor.getCurrentTake()), juce::sendNotification);
+        
+        statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::red);
+        DBG("Started recording");
     }
     else
     {
-        statusLabel.setText("Failed to fetch tracks", juce::sendNotification);
+        statusLabel.setText(audioProcessor.hasOpenSession() ? "⏹ Stopped - " + juce::String(audioProcessor.getCurrentTake()) + " take(s) in session"
+                                                            : "⏹ Stopped", juce::sendNotification);
+        statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::orange);
+        DBG("Stopped recording");
+    }
+    
+    statusLabel.setColour(juce::Label::textColourId, juce::Colours::white);
+    recordButton.repaint();
+    statusLabel.repaint();
+}
+
+void AuxleeAudioProcessorEditor::showFinishedSession(bool finished, int unverifiedTakes, const juce::String& verifiedOn)
+{
+    updateRecordingStatus();
+    
+    if (!finished)
+    {
+        statusLabel.setText("Failed to finish session", juce::sendNotification);
         statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::red);
+        return;
     }
+    
+    audioProcessor.refreshConnection();  // the new takes show up once synced
+    
+    if (unverifiedTakes == 0)
+    {
+        statusLabel.setText("✓ Session finished and verified (" + verifiedOn + ")", juce::sendNotification);
+        statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::green);
+    }
+    else
+    {
+        statusLabel.setText("⚠ " + juce::String(unverifiedTakes) + " take(s) incomplete (" + verifiedOn + ")", juce::sendNotification);
+        statusLabel.setColour(juce::Label::backgroundColourId, juce::Colours::orange);
+    }
+}
+
+void AuxleeAudioProcessorEditor::applyPunchSettings()
+{
+    audioProcessor.setPunch(punchButton.getToggleState(),
+                            { punchInEditor.getText().getDoubleValue(), punchOutEditor.getText().getDoubleValue() });
+    
+    // Show the values the processor actually settled on (out is never before in)
+    auto region = audioProcessor.getPunchRegion();
+    punchInEditor.setText(juce::String(region.getStart(), 2), false);
+    punchOutEditor.setText(juce::String(region.getEnd(), 2), false);
+}
+
+void AuxleeAudioProcessorEditor::applyLoopSettings()
+{
+    audioProcessor.setPlaybackLoopRegion({ loopStartEditor.getText().getDoubleValue(), loopEndEditor.getText().getDoubleValue() });
+    
+    auto region = audioProcessor.getPlaybackLoopRegion();
+    loopStartEditor.setText(juce::String(region.getStart(), 2), false);
+    loopEndEditor.setText(juce::String(region.getEnd(), 2), false);
+}
+
+void AuxleeAudioProcessorEditor::refreshTrackList()
+{
+    // Show whatever we already know about immediately; the deltas are pulled in the background
+    populateTrackSelector();
+    audioProcessor.refreshConnection();
+    reportConnection = true;
+}
+
+void AuxleeAudioProcessorEditor::populateTrackSelector()
+{
+    auto selectedIndex = trackSelector.getSelectedItemIndex();
+    auto selectedId = juce::isPositiveAndBelow(selectedIndex, trackIds.size()) ? trackIds[selectedIndex] : juce::String();
+    
+    trackSelector.clear(juce::dontSendNotification);
+    trackIds.clear();
+    
+    auto& tracks = audioProcessor.getCachedTracks();
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+        auto& track = tracks.getReference(i);
+        auto name = track.name.isNotEmpty() ? track.name : "Track " + juce::String(i + 1);
+        auto seconds = juce::roundToInt(track.durationSeconds);
+        
+        trackSelector.addItem(name + juce::String::formatted("  (%d:%02d)", seconds / 60, seconds % 60), i + 1);
+        trackIds.add(track.id);
+    }
+    
+    loadTrackButton.setEnabled(trackIds.size() > 0);
+    
+    if (trackIds.size() > 0)
+    {
+        auto index = trackIds.indexOf(selectedId);
+        trackSelector.setSelectedId(index >= 0 ? index + 1 : 1, juce::dontSendNotification);
+    }
+    
+    showSelectedWaveform();
+}
+
+void AuxleeAudioProcessorEditor::showSelectedWaveform()
+{
+    auto selectedIndex = trackSelector.getSelectedItemIndex();
+    auto trackId = juce::isPositiveAndBelow(selectedIndex, trackIds.size()) ? trackIds[selectedIndex] : juce::String();
+    
+    if (trackId == waveformTrackId)
+        return;
+    
+    waveformTrackId = trackId;
+    
+    auto cached = peakCache.find(trackId);
+    if (cached != peakCache.end() && waveformView.setPeakData(cached->second))
+        return;
+    
+    waveformView.clear();
+    if (trackId.isEmpty())
+        return;
+    
+    // The overview is a few KB whatever the take length, so previewing doesn't download audio
+    audioProcessor.fetchTrackPeaksAsync(trackId, [editor = juce::Component::SafePointer<AuxleeAudioProcessorEditor>(this), trackId](const juce::MemoryBlock& peakData)
+    {
+        if (editor == nullptr || peakData.isEmpty())
+            return;
+        
+        editor->peakCache[trackId] = peakData;
+        
+        // Only show it if the selection hasn't moved on while it downloaded
+        if (editor->waveformTrackId == trackId)
+            editor->waveformView.setPeakData(peakData);
+    });
 }
 
 void AuxleeAudioProcessorEditor::loadSelectedTrack()
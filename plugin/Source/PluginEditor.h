@@ -2,6 +2,8 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "WaveformView.h"
+#include "LevelMeter.h"
 
 class AuxleeAudioProcessorEditor : public juce::AudioProcessorEditor,
                                     private juce::Timer
@@ -16,25 +18,66 @@ public:
 private:
     void timerCallback() override;
     void refreshTrackList();
+    void updateConnectionStatus();
+    void showConnectedLayout();
+    void populateTrackSelector();
+    void showSelectedWaveform();
     void loadSelectedTrack();
+    void updateRecordingStatus();
+    void showFinishedSession(bool finished, int unverifiedTakes, const juce::String& verifiedOn);
+    void applyPunchSettings();
+    void applyLoopSettings();
+    void updateInputMeterCount();
 
     AuxleeAudioProcessor& audioProcessor;
 
     juce::TextButton recordButton;
+    juce::TextButton finishSessionButton;
+    juce::ToggleButton punchButton;
+    juce::TextEditor punchInEditor;
+    juce::TextEditor punchOutEditor;
     juce::Label apiUrlLabel;
     juce::TextEditor apiUrlEditor;
+    juce::Label backupUrlLabel;
+    juce::TextEditor backupUrlEditor;
     juce::Label usernameLabel;
     juce::TextEditor usernameEditor;
     juce::Label passwordLabel;
     juce::TextEditor passwordEditor;
     juce::TextButton connectButton;
     juce::Label statusLabel;
+    ConnectionWarmup::State shownConnectionState = ConnectionWarmup::State::idle;
+    int shownTrackListRevision = 0;
+    bool reportConnection = false;  // status label shows the connection until it settles
+    
+    // Metering and upload health, refreshed from the timer
+    juce::Label inputMeterLabel;
+    LevelMeter inputMeters[AuxleeAudioProcessor::maxChannels];
+    float displayedPeaks[AuxleeAudioProcessor::maxChannels] = {};
+    int shownMeterChannels = 0;  // the window grows to fit a meter per input channel
+    juce::Label backlogLabel;
+    LevelMeter backlogMeter;
+    juce::Label streamStatsLabel;
+    juce::Label uploadQualityLabel;
+    juce::ComboBox uploadQualitySelector;
+    juce::ToggleButton localCopyButton;
+    juce::Label uploadLimitLabel;
+    juce::ComboBox uploadLimitSelector;
     
     // Track management UI
     juce::Label tracksLabel;
     juce::ComboBox trackSelector;
+    WaveformView waveformView;
+    juce::String waveformTrackId;
+    std::map<juce::String, juce::MemoryBlock> peakCache;  // overviews never change once a take is finalized
     juce::TextButton refreshTracksButton;
     juce::TextButton loadTrackButton;
+    juce::ToggleButton followHostButton;
+    juce::ToggleButton loopButton;
+    juce::TextEditor loopStartEditor;
+    juce::TextEditor loopEndEditor;
+    juce::Label playbackLevelLabel;
+    juce::Slider playbackLevelSlider;
     juce::Array<juce::String> trackIds;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AuxleeAudioProcessorEditor)
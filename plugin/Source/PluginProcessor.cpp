@@ -7,11 +7,30 @@ AuxleeAudioProcessor::AuxleeAudioProcessor()
                     .withOutput("Output", juce::AudioChannelSet::stereo(), true))
 {
     networkClient = std::make_unique<NetworkClient>();
-    audioStreamer = std::make_unique<AudioStreamer>(networkClient.get());
+    primarySink = std::make_unique<HttpUploadSink>("Primary");
+    backupSink = std::make_unique<HttpUploadSink>("Backup");
+    primarySink->setRateLimiter(&uploadRateLimiter);
+    backupSink->setRateLimiter(&uploadRateLimiter);
+    localSink = std::make_unique<FileUploadSink>(juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                                                     .getChildFile("Auxlee").getChildFile("Recordings"));
+    audioStreamer = std::make_unique<AudioStreamer>();
+    updateUploadSinks();
+    connectionWarmup->addChangeListener(this);
+    
+    // A take still mapped when the cache was trimmed can go once playback lets go of it
+    playbackEngine.onSourcesReleased = [this] { audioFileCache.trim(playbackEngine.getMappedFiles()); };
 }
 
 AuxleeAudioProcessor::~AuxleeAudioProcessor()
 {
+    connectionWarmup->removeChangeListener(this);
+
+    // A session still finishing uses the streamer and the sinks; every wait
+    // in it has a timeout, so this can't hang
+    backgroundJobs.removeAllJobs(true, -1);
+
+    // The streamer drains into the sinks, so it has to go first
+    audioStreamer.reset();
 }
 
 const juce::String AuxleeAudioProcessor::getName() const
@@ -67,7 +86,9 @@ void AuxleeAudioProcessor::changeProgramName(int index, const juce::String& newN
 
 void AuxleeAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    audioStreamer->prepare(sampleRate, samplesPerBlock);
+    audioStreamer->setNonRealtime(isNonRealtime());
+    audioStreamer->prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    playbackEngine.prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
 }
 
 void AuxleeAudioProcessor::releaseResources()
@@ -77,8 +98,9 @@ void AuxleeAudioProcessor::releaseResources()
 
 bool AuxleeAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Chunks carry every input channel, so multichannel tracks upload whole
+    auto numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels < 1 || numChannels > maxChannels)
         return false;
 
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
@@ -92,61 +114,105 @@ void AuxleeAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::
     juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
 
-    // If playing back, mix playback audio into output
-    if (isPlaying.load())
+    // Lets the streamer block instead of dropping while the host bounces offline
+    audioStreamer->setNonRealtime(isNonRealtime());
+
+    // Publish input levels for the editor's meters
+    for (int channel = 0; channel < juce::jmin(buffer.getNumChannels(), maxChannels); ++channel)
     {
-        juce::ScopedLock lock(playbackLock);
+        auto& level = inputLevels[static_cast<size_t>(channel)];
+        auto blockPeak = buffer.getMagnitude(channel, 0, buffer.getNumSamples());
+        auto previousPeak = level.peak.load();
         
-        int samplesToPlay = juce::jmin(buffer.getNumSamples(), 
-                                       playbackBuffer.getNumSamples() - playbackPosition.load());
-        
-        if (samplesToPlay > 0)
+        while (blockPeak > previousPeak && !level.peak.compare_exchange_weak(previousPeak, blockPeak))
         {
-            for (int channel = 0; channel < juce::jmin(buffer.getNumChannels(), playbackBuffer.getNumChannels()); ++channel)
-            {
-                buffer.copyFrom(channel, 0, playbackBuffer, channel, playbackPosition.load(), samplesToPlay);
-            }
-            
-            playbackPosition += samplesToPlay;
-            
-            // Stop if we've reached the end
-            if (playbackPosition >= playbackBuffer.getNumSamples())
-            {
-                isPlaying = false;
-                playbackPosition = 0;
-                DBG("Playback finished");
-            }
         }
+        
+        level.rms = buffer.getRMSLevel(channel, 0, buffer.getNumSamples());
     }
 
-    // Send audio to streamer if recording AND there's actual audio signal
+    // Host timeline position of this block, only while the transport runs
+    juce::Optional<juce::int64> hostPosition;
+    if (auto* playHead = getPlayHead())
+        if (auto position = playHead->getPosition())
+            if (position->getIsPlaying())
+                hostPosition = position->getTimeInSamples();
+
     if (recording)
     {
-        // Check if buffer contains any audio (not silence)
-        bool hasAudio = false;
-        const float silenceThreshold = 0.0001f; // -80dB
+        auto captureRange = juce::Range<int>(0, buffer.getNumSamples());
         
-        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        if (punchEnabled)
         {
-            const float* channelData = buffer.getReadPointer(channel);
-            for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+            // Sample-accurate punch: only the part of the block inside the region is captured
+            auto sampleRate = getSampleRate();
+            juce::Range<juce::int64> punchRange(static_cast<juce::int64>(punchInSeconds.load() * sampleRate),
+                                                static_cast<juce::int64>(punchOutSeconds.load() * sampleRate));
+            juce::Range<juce::int64> inside;
+            
+            if (hostPosition)
+                inside = juce::Range<juce::int64>(*hostPosition, *hostPosition + buffer.getNumSamples()).getIntersectionWith(punchRange);
+            
+            if (inside.isEmpty())
+            {
+                captureRange = {};
+            }
+            else
             {
-                if (std::abs(channelData[sample]) > silenceThreshold)
+                if (!punchTakeActive)
                 {
-                    hasAudio = true;
-                    break;
+                    audioStreamer->startTake(false);
+                    punchTakeActive = true;
                 }
+                
+                captureRange = { static_cast<int>(inside.getStart() - *hostPosition),
+                                 static_cast<int>(inside.getEnd() - *hostPosition) };
             }
-            if (hasAudio)
-                break;
         }
         
-        // Only send if there's actual audio signal
-        if (hasAudio)
+        // The streamer regroups whatever block size we get and gates silence itself
+        if (!captureRange.isEmpty())
+        {
+            juce::Optional<juce::int64> capturePosition;
+            if (hostPosition)
+                capturePosition = *hostPosition + captureRange.getStart();
+            
+            audioStreamer->addAudioData(buffer, captureRange.getStart(), captureRange.getLength(), capturePosition);
+        }
+        
+        // Punched out (or the transport stopped): the next pass is a new take
+        if (punchTakeActive && captureRange.getEnd() < buffer.getNumSamples())
         {
-            audioStreamer->addAudioData(buffer);
+            audioStreamer->endTakeFromAudioThread();
+            punchTakeActive = false;
         }
     }
+    else
+    {
+        punchTakeActive = false;
+    }
+
+    // Always keep the last few seconds so a new take can start before the button press
+    audioStreamer->pushPreroll(buffer);
+
+    // Mix playback on top of the input after capture, so auditioning a take never ends up in the recording
+    playbackEngine.process(buffer, getPlayHead());
+}
+
+float AuxleeAudioProcessor::takeInputPeak(int channel)
+{
+    if (!juce::isPositiveAndBelow(channel, maxChannels))
+        return 0.0f;
+    
+    return inputLevels[static_cast<size_t>(channel)].peak.exchange(0.0f);
+}
+
+float AuxleeAudioProcessor::getInputRms(int channel) const
+{
+    if (!juce::isPositiveAndBelow(channel, maxChannels))
+        return 0.0f;
+    
+    return inputLevels[static_cast<size_t>(channel)].rms.load();
 }
 
 bool AuxleeAudioProcessor::hasEditor() const
@@ -164,6 +230,22 @@ void AuxleeAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
     std::unique_ptr<juce::XmlElement> xml(new juce::XmlElement("AuxleeAudioPluginSettings"));
     xml->setAttribute("apiUrl", apiUrl);
     xml->setAttribute("authUsername", authUsername);
+    xml->setAttribute("backupApiUrl", backupApiUrl);
+    xml->setAttribute("keepLocalCopy", keepLocalCopy);
+    xml->setAttribute("trackCacheSizeMB", static_cast<int>(audioFileCache.getMaxSizeBytes() / (1024 * 1024)));
+    xml->setAttribute("followHostTransport", playbackEngine.isFollowingHostTransport());
+    xml->setAttribute("loopPlayback", playbackEngine.isLooping());
+    xml->setAttribute("loopStart", loopRegionSeconds.getStart());
+    xml->setAttribute("loopEnd", loopRegionSeconds.getEnd());
+    xml->setAttribute("playbackLevel", playbackEngine.getPlaybackLevel());
+    xml->setAttribute("inputLevel", playbackEngine.getInputLevel());
+    xml->setAttribute("prerollSeconds", audioStreamer->getPrerollSeconds());
+    xml->setAttribute("uploadBitrateKbps", audioStreamer->getLossyBitrateKbps());
+    xml->setAttribute("uploadSampleFormat", static_cast<int>(audioStreamer->getSampleFormat()));
+    xml->setAttribute("uploadRateLimitKbps", uploadRateLimiter.getRateKbps());
+    xml->setAttribute("punchEnabled", punchEnabled.load());
+    xml->setAttribute("punchIn", punchInSeconds.load());
+    xml->setAttribute("punchOut", punchOutSeconds.load());
     
     copyXmlToBinary(*xml, destData);
 }
@@ -178,113 +260,240 @@ void AuxleeAudioProcessor::setStateInformation(const void* data, int sizeInBytes
         {
             apiUrl = xmlState->getStringAttribute("apiUrl");
             authUsername = xmlState->getStringAttribute("authUsername");
+            backupApiUrl = xmlState->getStringAttribute("backupApiUrl");
+            keepLocalCopy = xmlState->getBoolAttribute("keepLocalCopy", false);
+            networkClient->setApiUrl(apiUrl);
+            networkClient->setAuthentication(authUsername, authPassword);
+            updateUploadSinks();
+            
+            // The list synced last time needs no password, so it shows before anyone signs in
+            trackCache.open(apiUrl, authUsername);
+            trackCache.load();
+            ++trackListRevision;
+            
+            // Only queues a check; a server another instance already signed in to applies right away
+            connectionWarmup->request(apiUrl, authUsername, authPassword, false);
+            applyWarmupStatus();
+            
+            if (xmlState->hasAttribute("trackCacheSizeMB"))
+                setTrackCacheSizeMB(xmlState->getIntAttribute("trackCacheSizeMB"));
+            
+            setPlaybackFollowsHost(xmlState->getBoolAttribute("followHostTransport", false));
+            setPlaybackLooping(xmlState->getBoolAttribute("loopPlayback", false));
+            setPlaybackLoopRegion({ xmlState->getDoubleAttribute("loopStart", 0.0), xmlState->getDoubleAttribute("loopEnd", 0.0) });
+            setPlaybackLevel(static_cast<float>(xmlState->getDoubleAttribute("playbackLevel", 1.0)));
+            setInputLevel(static_cast<float>(xmlState->getDoubleAttribute("inputLevel", 1.0)));
+            setPrerollSeconds(xmlState->getDoubleAttribute("prerollSeconds", audioStreamer->getPrerollSeconds()));
+            setUploadBitrateKbps(xmlState->getIntAttribute("uploadBitrateKbps", 0));
+            setUploadSampleFormat(static_cast<AudioStreamer::SampleFormat>(
+                juce::jlimit(0, SampleKernels::numFormats - 1, xmlState->getIntAttribute("uploadSampleFormat", 0))));
+            setUploadRateLimitKbps(xmlState->getIntAttribute("uploadRateLimitKbps", 0));
+            setPunch(xmlState->getBoolAttribute("punchEnabled", false),
+                     { xmlState->getDoubleAttribute("punchIn", 0.0), xmlState->getDoubleAttribute("punchOut", 0.0) });
         }
     }
 }
 
 void AuxleeAudioProcessor::setRecording(bool shouldRecord)
 {
-    recording = shouldRecord;
+    if (shouldRecord == recording.load())
+        return;
     
-    if (recording)
+    if (shouldRecord)
     {
-        // Start a new session
-        currentSessionId = networkClient->startSession();
-        if (currentSessionId.isNotEmpty())
-        {
-            audioStreamer->setSessionId(currentSessionId);
-            audioStreamer->start();
-            DBG("Started recording session: " + currentSessionId);
-        }
-        else
+        // The streamer's session is still being finalized
+        if (finishingSession)
+            return;
+        
+        // Each server's session is opened by its first upload, so a server
+        // that's down shows up in its sink status instead of blocking the take
+        if (!sessionOpen)
         {
-            DBG("Failed to start session");
-            recording = false;
+            audioStreamer->beginSession();
+            sessionOpen = true;
+            DBG("Started recording session");
         }
+        
+        // Punch takes start from the audio thread when the playhead enters the region
+        if (!punchEnabled)
+            audioStreamer->startTake(true);
+        
+        audioStreamer->start();
+        recording = true;
     }
     else
     {
+        recording = false;
         audioStreamer->stop();
-        
-        // Finalize the session
-        if (currentSessionId.isNotEmpty())
-        {
-            networkClient->finalizeSession(currentSessionId);
-            DBG("Finalized session: " + currentSessionId);
-            currentSessionId = "";
-        }
     }
 }
 
-bool AuxleeAudioProcessor::fetchTracks(juce::Array<juce::String>& trackList)
+void AuxleeAudioProcessor::finishSessionAsync(std::function<void(bool, int, const juce::String&)> onFinished)
 {
-    return networkClient->fetchRecordedTracks(trackList);
-}
-
-bool AuxleeAudioProcessor::loadTrack(const juce::String& trackId)
-{
-    juce::MemoryBlock audioData;
+    setRecording(false);
+    
+    if (finishingSession)
+        return;
     
-    if (!networkClient->downloadTrack(trackId, audioData))
+    if (!sessionOpen)
     {
-        DBG("Failed to download track");
-        return false;
+        onFinished(false, 0, {});
+        return;
     }
     
-    DBG("Downloaded " + juce::String(audioData.getSize()) + " bytes");
+    finishingSession = true;
     
-    // Keep the memory block alive while parsing
-    auto inputStream = std::make_unique<juce::MemoryInputStream>(audioData, false);
+    backgroundJobs.addJob([this, processor = juce::WeakReference<AuxleeAudioProcessor>(this), onFinished = std::move(onFinished)]
+    {
+        int unverifiedTakes = 0;
+        juce::String verifiedOn;
+        bool finished = finishSession(unverifiedTakes, verifiedOn);
+        
+        juce::MessageManager::callAsync([processor, onFinished, finished, unverifiedTakes, verifiedOn]
+        {
+            if (processor == nullptr)
+                return;
+            
+            processor->sessionOpen = false;
+            processor->finishingSession = false;
+            onFinished(finished, unverifiedTakes, verifiedOn);
+        });
+    });
+}
+
+bool AuxleeAudioProcessor::finishSession(int& unverifiedTakes, juce::String& verifiedOn)
+{
+    unverifiedTakes = 0;
+    verifiedOn = {};
     
-    juce::WavAudioFormat wavFormat;
-    std::unique_ptr<juce::AudioFormatReader> reader(wavFormat.createReaderFor(inputStream.get(), true));
+    auto results = audioStreamer->finishSession(15000);
     
-    if (reader == nullptr)
+    // Sinks are ordered primary, backup, local copy, so ties go to the primary
+    auto best = AudioStreamer::findBestResult(results);
+    if (best < 0)
     {
-        DBG("Failed to parse WAV data");
+        DBG("No destination finished the session");
         return false;
     }
     
-    // Release ownership so reader can manage the stream
-    inputStream.release();
-    
-    DBG("Parsed WAV: " + juce::String(reader->lengthInSamples) + " samples, " + 
-        juce::String(reader->numChannels) + " channels, " + 
-        juce::String(reader->sampleRate) + " Hz");
+    unverifiedTakes = results.getReference(best).unverifiedTakes;
+    verifiedOn = results.getReference(best).name;
+    DBG("Finished session on " + verifiedOn);
+    return true;
+}
+
+void AuxleeAudioProcessor::setPunch(bool enabled, juce::Range<double> regionSeconds)
+{
+    punchInSeconds = juce::jmax(0.0, regionSeconds.getStart());
+    punchOutSeconds = juce::jmax(punchInSeconds.load(), regionSeconds.getEnd());
+    punchEnabled = enabled;
+}
+
+bool AuxleeAudioProcessor::loadTrack(const juce::String& trackId)
+{
+    juce::String etag;
+    juce::Optional<juce::int64> hostStart;
+    if (auto* info = trackCache.findTrack(trackId))
+    {
+        etag = info->etag;
+        hostStart = info->hostStart;
+    }
     
-    // Create temporary buffer and read audio
-    juce::AudioBuffer<float> tempBuffer(static_cast<int>(reader->numChannels),
-                                        static_cast<int>(reader->lengthInSamples));
+    // Repeat auditions of the same take come straight from disk
+    auto trackFile = audioFileCache.findTrack(trackId, etag);
     
-    if (!reader->read(&tempBuffer, 0, static_cast<int>(reader->lengthInSamples), 0, true, true))
+    if (trackFile.existsAsFile())
     {
-        DBG("Failed to read audio data");
-        return false;
+        DBG("Playing cached track " + trackFile.getFileName());
     }
-    
-    // Safely swap the buffer on the audio thread
+    else
     {
-        juce::ScopedLock lock(playbackLock);
+        juce::String downloadedEtag;
+        auto tempFile = audioFileCache.getPartialFileFor(trackId);
         
-        // Stop current playback
-        isPlaying = false;
-        playbackPosition = 0;
+        if (!networkClient->downloadTrack(trackId, tempFile, downloadedEtag))
+        {
+            DBG("Failed to download track");
+            return false;
+        }
         
-        // Swap in new buffer
-        playbackBuffer = std::move(tempBuffer);
+        trackFile = audioFileCache.getFileFor(trackId, downloadedEtag.isNotEmpty() ? downloadedEtag : etag);
+        if (!tempFile.moveFileTo(trackFile))
+        {
+            DBG("Failed to move downloaded track into the cache");
+            tempFile.deleteFile();
+            return false;
+        }
         
-        // Start playback
-        isPlaying = true;
+        DBG("Downloaded " + juce::String(trackFile.getSize()) + " bytes");
     }
     
+    // Playback reads the mapped file directly, so nothing is decoded here
+    if (!playbackEngine.load(trackFile))
+    {
+        DBG("Failed to parse WAV data");
+        return false;
+    }
+    
+    loadedTrackId = trackId;
+    audioFileCache.trim(playbackEngine.getMappedFiles());
+    
+    // Following the host lines the take up with where it was recorded; takes
+    // recorded with the transport stopped start at the top of the timeline
+    playbackEngine.setHostStartPosition(hostStart.orFallback(0));
+    setPlaybackLoopRegion(loopRegionSeconds);
+    
     DBG("Track loaded and playing");
     return true;
 }
 
+void AuxleeAudioProcessor::fetchTrackPeaksAsync(const juce::String& trackId, std::function<void(const juce::MemoryBlock&)> onFetched)
+{
+    // The job gets a client of its own, so nothing it touches changes under it
+    backgroundJobs.addJob([url = apiUrl, username = authUsername, password = authPassword, trackId, onFetched = std::move(onFetched)]
+    {
+        NetworkClient client;
+        client.setApiUrl(url);
+        client.setAuthentication(username, password);
+        
+        juce::MemoryBlock peakData;
+        if (!client.fetchTrackPeaks(trackId, peakData))
+            peakData.reset();
+        
+        juce::MessageManager::callAsync([onFetched, peakData] { onFetched(peakData); });
+    });
+}
+
+void AuxleeAudioProcessor::setTrackCacheSizeMB(int sizeMB)
+{
+    audioFileCache.setMaxSizeBytes(static_cast<juce::int64>(sizeMB) * 1024 * 1024);
+    audioFileCache.trim(playbackEngine.getMappedFiles());
+}
+
+void AuxleeAudioProcessor::setPlaybackFollowsHost(bool shouldFollow)
+{
+    playbackEngine.setFollowHostTransport(shouldFollow);
+}
+
+void AuxleeAudioProcessor::setPlaybackLoopRegion(juce::Range<double> regionSeconds)
+{
+    loopRegionSeconds = { juce::jmax(0.0, regionSeconds.getStart()), juce::jmax(0.0, regionSeconds.getEnd()) };
+
+    // The engine works in take samples, so this is redone whenever a take is loaded
+    auto sampleRate = playbackEngine.getTrackSampleRate();
+    if (sampleRate <= 0.0)
+        sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+
+    playbackEngine.setLoopRegion({ static_cast<juce::int64>(loopRegionSeconds.getStart() * sampleRate),
+                                   static_cast<juce::int64>(loopRegionSeconds.getEnd() * sampleRate) });
+}
+
 void AuxleeAudioProcessor::setApiUrl(const juce::String& url)
 {
     apiUrl = url;
     networkClient->setApiUrl(url);
+    trackCache.open(apiUrl, authUsername);
+    updateUploadSinks();
 }
 
 void AuxleeAudioProcessor::setAuthentication(const juce::String& username, const juce::String& password)
@@ -292,11 +501,72 @@ void AuxleeAudioProcessor::setAuthentication(const juce::String& username, const
     authUsername = username;
     authPassword = password;
     networkClient->setAuthentication(username, password);
+    trackCache.open(apiUrl, authUsername);
+    updateUploadSinks();
+}
+
+void AuxleeAudioProcessor::setBackupApiUrl(const juce::String& url)
+{
+    backupApiUrl = url;
+    updateUploadSinks();
 }
 
-bool AuxleeAudioProcessor::testConnection()
+void AuxleeAudioProcessor::setKeepLocalCopy(bool shouldKeep)
 {
-    return networkClient->testConnection();
+    keepLocalCopy = shouldKeep;
+    updateUploadSinks();
+}
+
+void AuxleeAudioProcessor::updateUploadSinks()
+{
+    primarySink->setServer(apiUrl, authUsername, authPassword);
+    backupSink->setServer(backupApiUrl, authUsername, authPassword);
+
+    juce::Array<UploadSink*> sinks;
+    if (primarySink->hasServer())
+        sinks.add(primarySink.get());
+    if (backupSink->hasServer())
+        sinks.add(backupSink.get());
+    if (keepLocalCopy)
+        sinks.add(localSink.get());
+
+    audioStreamer->setSinks(sinks);
+}
+
+void AuxleeAudioProcessor::refreshConnection()
+{
+    connectionWarmup->request(apiUrl, authUsername, authPassword, true);
+}
+
+void AuxleeAudioProcessor::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    applyWarmupStatus();
+}
+
+void AuxleeAudioProcessor::applyWarmupStatus()
+{
+    auto status = connectionWarmup->getStatus(apiUrl, authUsername);
+    connectionState = status.state;
+
+    if (status.state != ConnectionWarmup::State::signedIn)
+        return;
+
+    // Signed in by this instance or by another one on the same server
+    if (authPassword != status.password)
+    {
+        authPassword = status.password;
+        networkClient->setAuthentication(authUsername, authPassword);
+        updateUploadSinks();
+    }
+
+    // The warm-up thread synced the shared cache file; pick up what it wrote
+    if (status.syncCount != trackListSyncCount)
+    {
+        trackListSyncCount = status.syncCount;
+        trackCache.open(apiUrl, authUsername);
+        trackCache.load();
+        ++trackListRevision;
+    }
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -3,8 +3,15 @@
 #include <JuceHeader.h>
 #include "AudioStreamer.h"
 #include "NetworkClient.h"
+#include "HttpUploadSink.h"
+#include "FileUploadSink.h"
+#include "TrackCache.h"
+#include "ConnectionWarmup.h"
+#include "AudioFileCache.h"
+#include "PlaybackEngine.h"
 
-class AuxleeAudioProcessor : public juce::AudioProcessor
+class AuxleeAudioProcessor : public juce::AudioProcessor,
+                             private juce::ChangeListener
 {
 public:
     AuxleeAudioProcessor();
@@ -37,28 +44,133 @@ public:
     void setStateInformation(const void* data, int sizeInBytes) override;
 
     // Custom methods
+    // A session spans every take until finishSession(), and starting or
+    // stopping takes never waits on the network. Chunks go to the primary
+    // server, the backup server if one is set, and a local folder if enabled.
+    // finishSessionAsync() assembles every take into its own track on each
+    // server and checks it against the chunks we sent. That waits on the
+    // uploads and the servers, so it runs on a background thread and calls
+    // onFinished on the message thread: the first server holding a verified
+    // copy is reported in verifiedOn, and unverifiedTakes counts the takes
+    // that don't match on the best one. Recording can't restart until then.
     void setRecording(bool shouldRecord);
-    bool isRecording() const { return recording; }
+    bool isRecording() const { return recording.load(); }
+    void finishSessionAsync(std::function<void(bool finished, int unverifiedTakes, const juce::String& verifiedOn)> onFinished);
+    bool hasOpenSession() const { return sessionOpen; }
+    bool isFinishingSession() const { return finishingSession; }
+    int getCurrentTake() const { return audioStreamer->getCurrentTake(); }
+    // With punch enabled, recording only captures while the host plays inside
+    // the region; every pass through it becomes a take of its own
+    void setPunch(bool enabled, juce::Range<double> regionSeconds);
+    bool isPunchEnabled() const { return punchEnabled.load(); }
+    juce::Range<double> getPunchRegion() const { return { punchInSeconds.load(), punchOutSeconds.load() }; }
     void setApiUrl(const juce::String& url);
     void setAuthentication(const juce::String& username, const juce::String& password);
-    bool testConnection();
-    bool fetchTracks(juce::Array<juce::String>& trackList);
+    juce::String getApiUrl() const { return apiUrl; }
+    juce::String getAuthUsername() const { return authUsername; }
+    // Same credentials as the primary; empty disables the backup. Like the
+    // local copy, changes apply from the next session.
+    void setBackupApiUrl(const juce::String& url);
+    juce::String getBackupApiUrl() const { return backupApiUrl; }
+    void setKeepLocalCopy(bool shouldKeep);
+    bool keepsLocalCopy() const { return keepLocalCopy; }
+    // Construction and state restore never wait on the network: the server is
+    // checked and the track list synced on the shared warm-up thread, and the
+    // editor follows along through these. An instance restored without a
+    // password signs in once any instance on the same server does.
+    void refreshConnection();
+    ConnectionWarmup::State getConnectionState() const { return connectionState; }
+    int getTrackListRevision() const { return trackListRevision; }  // bumped when getCachedTracks() is reloaded
+    const juce::Array<TrackInfo>& getCachedTracks() const { return trackCache.getTracks(); }
     bool loadTrack(const juce::String& trackId);
+    // Fetches a take's waveform overview on a background thread and hands it
+    // to onFetched on the message thread; the block is empty if it failed
+    void fetchTrackPeaksAsync(const juce::String& trackId, std::function<void(const juce::MemoryBlock&)> onFetched);
+    void setTrackCacheSizeMB(int sizeMB);
+    // 0 = lossless WAV upload, otherwise Ogg Vorbis near this bitrate
+    void setUploadBitrateKbps(int kbps) { audioStreamer->setLossyBitrateKbps(kbps); }
+    int getUploadBitrateKbps() const { return audioStreamer->getLossyBitrateKbps(); }
+    // Sample format of lossless uploads (16/24-bit PCM or 32-bit float WAV)
+    void setUploadSampleFormat(AudioStreamer::SampleFormat format) { audioStreamer->setSampleFormat(format); }
+    AudioStreamer::SampleFormat getUploadSampleFormat() const { return audioStreamer->getSampleFormat(); }
+    // Caps what the server uploads use together; 0 is unlimited
+    void setUploadRateLimitKbps(int kbps) { uploadRateLimiter.setRateKbps(kbps); }
+    int getUploadRateLimitKbps() const { return uploadRateLimiter.getRateKbps(); }
+    void setPrerollSeconds(double seconds) { audioStreamer->setPrerollSeconds(seconds); }
+    double getPrerollSeconds() const { return audioStreamer->getPrerollSeconds(); }
+    void setPlaybackFollowsHost(bool shouldFollow);
+    bool playbackFollowsHost() const { return playbackEngine.isFollowingHostTransport(); }
+    void setPlaybackLooping(bool shouldLoop) { playbackEngine.setLooping(shouldLoop); }
+    bool isPlaybackLooping() const { return playbackEngine.isLooping(); }
+    // In seconds from the start of the take; an empty range loops the whole take
+    void setPlaybackLoopRegion(juce::Range<double> regionSeconds);
+    juce::Range<double> getPlaybackLoopRegion() const { return loopRegionSeconds; }
+    // Widest layout accepted (7.1), as wide as playback goes
+    static constexpr int maxChannels = 8;
+    // Metering for the editor, one meter per input channel; lock-free, safe
+    // to call while processBlock runs
+    int getNumMeteredChannels() const { return juce::jlimit(1, maxChannels, getTotalNumInputChannels()); }
+    float takeInputPeak(int channel);
+    float getInputRms(int channel) const;
+    AudioStreamer::Statistics getStreamerStatistics() const { return audioStreamer->getStatistics(); }
+
+    void seekPlayback(juce::int64 samplePosition) { playbackEngine.seek(samplePosition); }
+    juce::int64 getPlaybackPosition() const { return playbackEngine.getPosition(); }
+    const juce::String& getLoadedTrackId() const { return loadedTrackId; }
+    void setPlaybackLevel(float level) { playbackEngine.setPlaybackLevel(level); }
+    float getPlaybackLevel() const { return playbackEngine.getPlaybackLevel(); }
+    void setInputLevel(float level) { playbackEngine.setInputLevel(level); }
+    float getInputLevel() const { return playbackEngine.getInputLevel(); }
 
 private:
+    bool finishSession(int& unverifiedTakes, juce::String& verifiedOn);  // blocking, on backgroundJobs
+    void updateUploadSinks();
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void applyWarmupStatus();
+
+    // The sinks are declared first so they outlive the streamer feeding them,
+    // and the limiter before them since they hold on to it
+    UploadRateLimiter uploadRateLimiter;
+    std::unique_ptr<HttpUploadSink> primarySink;
+    std::unique_ptr<HttpUploadSink> backupSink;
+    std::unique_ptr<FileUploadSink> localSink;
     std::unique_ptr<AudioStreamer> audioStreamer;
     std::unique_ptr<NetworkClient> networkClient;
-    bool recording = false;
+    std::atomic<bool> recording{ false };
+    std::atomic<bool> punchEnabled{ false };
+    std::atomic<double> punchInSeconds{ 0.0 };
+    std::atomic<double> punchOutSeconds{ 0.0 };
+    bool punchTakeActive = false;  // audio thread only
     juce::String apiUrl;
     juce::String authUsername;
     juce::String authPassword;
-    juce::String currentSessionId;  // Track current recording session
+    juce::String backupApiUrl;
+    bool keepLocalCopy = false;
+    bool sessionOpen = false;  // message thread only
+    bool finishingSession = false;  // message thread only
+    juce::SharedResourcePointer<ConnectionWarmup> connectionWarmup;
+    ConnectionWarmup::State connectionState = ConnectionWarmup::State::idle;  // message thread only
+    int trackListSyncCount = 0;
+    int trackListRevision = 0;
+    TrackCache trackCache;
+    AudioFileCache audioFileCache;
+    juce::String loadedTrackId;
+    juce::Range<double> loopRegionSeconds;  // message thread only
+    
+    // Written by processBlock, read by the editor's timer
+    struct ChannelLevel
+    {
+        std::atomic<float> peak{ 0.0f };  // max since the editor last took it
+        std::atomic<float> rms{ 0.0f };   // most recent block
+    };
+    std::array<ChannelLevel, maxChannels> inputLevels;
+    
+    // Playback straight from the cached file
+    PlaybackEngine playbackEngine;
     
-    // Playback buffer
-    juce::AudioBuffer<float> playbackBuffer;
-    std::atomic<int> playbackPosition{ 0 };
-    std::atomic<bool> isPlaying{ false };
-    juce::CriticalSection playbackLock;
+    // Network requests made for the editor, so it never waits on them
+    juce::ThreadPool backgroundJobs{ 1 };
 
+    JUCE_DECLARE_WEAK_REFERENCEABLE(AuxleeAudioProcessor)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AuxleeAudioProcessor)
 };
@@ -0,0 +1,170 @@
+#include "SampleKernels.h"
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+    // Output formats. Conversion truncates towards zero, matching the SIMD paths.
+    struct Int16
+    {
+        static constexpr int bytes = 2;
+
+        static inline void write(float sample, juce::uint8* dest) noexcept
+        {
+            auto value = static_cast<juce::int16>(juce::jlimit(-1.0f, 1.0f, sample) * 32767.0f);
+            dest[0] = static_cast<juce::uint8>(value);
+            dest[1] = static_cast<juce::uint8>(value >> 8);
+        }
+    };
+
+    struct Int24
+    {
+        static constexpr int bytes = 3;
+
+        static inline void write(float sample, juce::uint8* dest) noexcept
+        {
+            auto value = static_cast<juce::int32>(juce::jlimit(-1.0f, 1.0f, sample) * 8388607.0f);
+            juce::ByteOrder::littleEndian24BitToChars(value, dest);
+        }
+    };
+
+    struct Float32
+    {
+        static constexpr int bytes = 4;
+
+        static inline void write(float sample, juce::uint8* dest) noexcept
+        {
+            juce::uint32 bits;
+            std::memcpy(&bits, &sample, sizeof(bits));
+            bits = juce::ByteOrder::swapIfBigEndian(bits);
+            std::memcpy(dest, &bits, sizeof(bits));
+        }
+    };
+
+    // NumChannels == 0 is the any-count fallback; otherwise the channel loop has a constant trip count.
+    // dest points at the output frame for startSample.
+    template <int NumChannels, typename SampleFormat>
+    void interleaveScalar(const float* const* channels, int numChannels, int startSample, int numSamples, juce::uint8* dest) noexcept
+    {
+        const int count = NumChannels > 0 ? NumChannels : numChannels;
+
+        for (int i = startSample; i < numSamples; ++i)
+        {
+            for (int channel = 0; channel < count; ++channel)
+            {
+                SampleFormat::write(channels[channel][i], dest);
+                dest += SampleFormat::bytes;
+            }
+        }
+    }
+
+    template <int NumChannels, typename SampleFormat>
+    void interleave(const float* const* channels, int numChannels, int numSamples, void* dest)
+    {
+        interleaveScalar<NumChannels, SampleFormat>(channels, numChannels, 0, numSamples, static_cast<juce::uint8*>(dest));
+    }
+
+   #if JUCE_USE_SSE_INTRINSICS || JUCE_USE_ARM_NEON
+    // 16-bit output is the default upload format, so mono and stereo get vector paths.
+    // Both targets are little-endian, so the lanes can be stored as they are.
+    template <>
+    void interleave<1, Int16>(const float* const* channels, int, int numSamples, void* dest)
+    {
+        auto* source = channels[0];
+        auto* out = static_cast<juce::int16*>(dest);
+        int i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        const auto scale = _mm_set1_ps(32767.0f), low = _mm_set1_ps(-1.0f), high = _mm_set1_ps(1.0f);
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            auto a = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i), low), high), scale));
+            auto b = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i + 4), low), high), scale));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+        }
+       #else
+        const auto scale = vdupq_n_f32(32767.0f), low = vdupq_n_f32(-1.0f), high = vdupq_n_f32(1.0f);
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto a = vcvtq_s32_f32(vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(source + i), low), high), scale));
+            vst1_s16(out + i, vqmovn_s32(a));
+        }
+       #endif
+
+        interleaveScalar<1, Int16>(channels, 1, i, numSamples, reinterpret_cast<juce::uint8*>(out + i));
+    }
+
+    template <>
+    void interleave<2, Int16>(const float* const* channels, int, int numSamples, void* dest)
+    {
+        auto* left = channels[0];
+        auto* right = channels[1];
+        auto* out = static_cast<juce::int16*>(dest);
+        int i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        const auto scale = _mm_set1_ps(32767.0f), low = _mm_set1_ps(-1.0f), high = _mm_set1_ps(1.0f);
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto l = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(left + i), low), high), scale));
+            auto r = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(right + i), low), high), scale));
+            // l0 r0 l1 r1 | l2 r2 l3 r3, then narrowed to eight interleaved shorts
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2),
+                             _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r)));
+        }
+       #else
+        const auto scale = vdupq_n_f32(32767.0f), low = vdupq_n_f32(-1.0f), high = vdupq_n_f32(1.0f);
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            int16x4x2_t frames;
+            frames.val[0] = vqmovn_s32(vcvtq_s32_f32(vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(left + i), low), high), scale)));
+            frames.val[1] = vqmovn_s32(vcvtq_s32_f32(vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(right + i), low), high), scale)));
+            vst2_s16(out + i * 2, frames);
+        }
+       #endif
+
+        interleaveScalar<2, Int16>(channels, 2, i, numSamples, reinterpret_cast<juce::uint8*>(out + i * 2));
+    }
+   #endif
+
+    template <typename SampleFormat>
+    SampleKernels::Interleaver selectForChannels(int numChannels)
+    {
+        switch (numChannels)
+        {
+            case 1:  return interleave<1, SampleFormat>;
+            case 2:  return interleave<2, SampleFormat>;
+            default: return interleave<0, SampleFormat>;
+        }
+    }
+}
+
+int SampleKernels::getBytesPerSample(Format format)
+{
+    switch (format)
+    {
+        case Format::int24:   return Int24::bytes;
+        case Format::float32: return Float32::bytes;
+        case Format::int16:
+        default:              return Int16::bytes;
+    }
+}
+
+SampleKernels::Interleaver SampleKernels::select(int numChannels, Format format)
+{
+    switch (format)
+    {
+        case Format::int24:   return selectForChannels<Int24>(numChannels);
+        case Format::float32: return selectForChannels<Float32>(numChannels);
+        case Format::int16:
+        default:              return selectForChannels<Int16>(numChannels);
+    }
+}
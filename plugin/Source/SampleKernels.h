@@ -0,0 +1,26 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Float-to-PCM interleaving kernels for chunk encoding. Each one is a
+// template instantiation for a fixed channel count (mono, stereo, or any
+// count) and output format, picked once by select() so the per-sample loops
+// carry no format or channel branches. The 16-bit mono/stereo kernels use
+// SSE2 or NEON when JUCE builds with them.
+namespace SampleKernels
+{
+    enum class Format
+    {
+        int16,
+        int24,
+        float32
+    };
+
+    static constexpr int numFormats = 3;
+
+    // Writes numSamples frames of channels[0 .. numChannels) as interleaved little-endian samples
+    using Interleaver = void (*)(const float* const* channels, int numChannels, int numSamples, void* dest);
+
+    int getBytesPerSample(Format format);
+    Interleaver select(int numChannels, Format format);
+}
@@ -0,0 +1,203 @@
+#include "TrackCache.h"
+
+TrackCache::TrackCache()
+{
+}
+
+TrackCache::~TrackCache()
+{
+}
+
+void TrackCache::open(const juce::String& apiUrl, const juce::String& username)
+{
+    // One cache file per server/user pair
+    auto key = juce::String::toHexString((apiUrl + "|" + username).hashCode64());
+    auto file = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                    .getChildFile("Auxlee")
+                    .getChildFile("TrackIndex")
+                    .getChildFile(key + ".json");
+
+    if (file == cacheFile)
+        return;
+
+    cacheFile = file;
+    load();
+}
+
+void TrackCache::clear()
+{
+    tracks.clear();
+    generation = {};
+    cursor = 0;
+}
+
+bool TrackCache::reset(const juce::String& newGeneration)
+{
+    bool hadTracks = !tracks.isEmpty();
+    clear();
+    generation = newGeneration;
+    return hadTracks;
+}
+
+void TrackCache::load()
+{
+    clear();
+
+    if (!cacheFile.existsAsFile())
+        return;
+
+    juce::var json;
+    if (juce::JSON::parse(cacheFile.loadFileAsString(), json).failed() || !json.isObject())
+        return;
+
+    generation = json["generation"].toString();
+    cursor = static_cast<juce::int64>(json["cursor"]);
+
+    if (auto* entries = json["tracks"].getArray())
+    {
+        for (auto& entry : *entries)
+        {
+            TrackInfo info;
+            info.id = entry["id"].toString();
+            info.name = entry["name"].toString();
+            info.durationSeconds = static_cast<double>(entry["duration"]);
+            info.sizeBytes = static_cast<juce::int64>(entry["size"]);
+            info.etag = entry["etag"].toString();
+            info.createdAt = entry["created_at"].toString();
+
+            if (!entry["host_start"].isVoid())
+                info.hostStart = static_cast<juce::int64>(entry["host_start"]);
+
+            if (info.id.isNotEmpty())
+                tracks.add(info);
+        }
+    }
+
+    DBG("Loaded " + juce::String(tracks.size()) + " cached track(s) from " + cacheFile.getFullPathName());
+}
+
+bool TrackCache::save() const
+{
+    if (cacheFile == juce::File())
+        return false;
+
+    juce::Array<juce::var> entries;
+    for (auto& info : tracks)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("id", info.id);
+        entry->setProperty("name", info.name);
+        entry->setProperty("duration", info.durationSeconds);
+        entry->setProperty("size", info.sizeBytes);
+        entry->setProperty("etag", info.etag);
+        entry->setProperty("created_at", info.createdAt);
+
+        if (info.hostStart.hasValue())
+            entry->setProperty("host_start", *info.hostStart);
+        entries.add(juce::var(entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("generation", generation);
+    root->setProperty("cursor", cursor);
+    root->setProperty("tracks", entries);
+
+    cacheFile.getParentDirectory().createDirectory();
+    return cacheFile.replaceWithText(juce::JSON::toString(juce::var(root), true));
+}
+
+bool TrackCache::applyChanges(const TrackChanges& changes)
+{
+    bool changed = false;
+    generation = changes.generation;
+
+    for (auto& trackId : changes.deletedIds)
+    {
+        auto index = indexOf(trackId);
+        if (index >= 0)
+        {
+            tracks.remove(index);
+            changed = true;
+        }
+    }
+
+    for (auto& info : changes.tracks)
+    {
+        auto index = indexOf(info.id);
+        if (index >= 0)
+            tracks.set(index, info);
+        else
+            tracks.add(info);
+
+        changed = true;
+    }
+
+    cursor = changes.cursor;
+    return changed;
+}
+
+const TrackInfo* TrackCache::findTrack(const juce::String& trackId) const
+{
+    auto index = indexOf(trackId);
+    return index >= 0 ? &tracks.getReference(index) : nullptr;
+}
+
+int TrackCache::indexOf(const juce::String& trackId) const
+{
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+        if (tracks.getReference(i).id == trackId)
+            return i;
+    }
+
+    return -1;
+}
+
+bool TrackCache::sync(NetworkClient& client, bool& listChanged, const std::function<bool()>& shouldStop)
+{
+    const int pageSize = 200;
+    const int maxPages = 100;
+    listChanged = false;
+
+    if (!isOpen())
+        return false;
+
+    auto startCursor = cursor;
+    bool complete = true;
+
+    for (int page = 0; page < maxPages; ++page)
+    {
+        if (shouldStop && shouldStop())
+        {
+            complete = false;
+            break;
+        }
+
+        TrackChanges changes;
+        auto sinceCursor = cursor;
+        
+        if (!client.fetchTrackChanges(sinceCursor, pageSize, changes))
+        {
+            DBG("Failed to fetch track changes");
+            return false;
+        }
+
+        // Server restarted since we last synced; start over from the beginning
+        if (sinceCursor > 0 && changes.generation != generation)
+        {
+            listChanged = reset(changes.generation) || listChanged;
+            continue;
+        }
+
+        listChanged = applyChanges(changes) || listChanged;
+
+        if (!changes.hasMore)
+            break;
+    }
+
+    if (listChanged || cursor != startCursor)
+        save();
+
+    DBG("Track sync: cursor " + juce::String(startCursor) + " -> " + juce::String(cursor));
+    return complete;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "NetworkClient.h"
+
+// Persistent local copy of the server's track list, kept up to date with
+// incremental change pages so the editor never has to download the full list.
+class TrackCache
+{
+public:
+    TrackCache();
+    ~TrackCache();
+
+    void open(const juce::String& apiUrl, const juce::String& username);
+    bool save() const;
+    // Re-reads the file, e.g. after another TrackCache on the same server synced it
+    void load();
+
+    // Pulls every change page since the cursor and saves; blocks on the network.
+    // shouldStop is checked between pages; pages already applied are kept.
+    bool sync(NetworkClient& client, bool& listChanged, const std::function<bool()>& shouldStop = {});
+
+    // Applies one page of changes; returns true if the visible list changed
+    bool applyChanges(const TrackChanges& changes);
+
+    // Drops everything after the server restarted with a new generation
+    bool reset(const juce::String& newGeneration);
+
+    const juce::Array<TrackInfo>& getTracks() const { return tracks; }
+    const TrackInfo* findTrack(const juce::String& trackId) const;
+    juce::int64 getCursor() const { return cursor; }
+    const juce::String& getGeneration() const { return generation; }
+    bool isOpen() const { return cacheFile != juce::File(); }
+
+private:
+    void clear();
+    int indexOf(const juce::String& trackId) const;
+
+    juce::File cacheFile;
+    juce::Array<TrackInfo> tracks;
+    juce::String generation;
+    juce::int64 cursor = 0;
+};
@@ -0,0 +1,56 @@
+#include "UploadRateLimiter.h"
+
+void UploadRateLimiter::setRateKbps(int kbps)
+{
+    juce::ScopedLock scopedLock(lock);
+    rateKbps = juce::jmax(0, kbps);
+    bytesPerMs = rateKbps.load() / 8.0;  // 1 kbps is 1000 bits per second
+    tokens = bytesPerMs * burstMs;
+    lastRefillMs = juce::Time::getMillisecondCounter();
+}
+
+void UploadRateLimiter::refill(juce::uint32 now)
+{
+    tokens = juce::jmin(bytesPerMs * burstMs, tokens + bytesPerMs * static_cast<double>(now - lastRefillMs));
+    lastRefillMs = now;
+}
+
+int UploadRateLimiter::tryAcquire(size_t numBytes, Priority priority)
+{
+    if (rateKbps.load() == 0)
+        return 0;
+
+    juce::ScopedLock scopedLock(lock);
+    auto now = juce::Time::getMillisecondCounter();
+    refill(now);
+
+    auto size = static_cast<double>(numBytes);
+
+    if (priority == Priority::live)
+    {
+        // Live chunks may run the bucket into debt, so one larger than the
+        // burst still goes out as soon as earlier traffic is paid for
+        if (tokens > 0.0)
+        {
+            tokens -= size;
+            return 0;
+        }
+
+        liveWaitingUntilMs = now + liveHoldMs;
+        return 1 + static_cast<int>(-tokens / bytesPerMs);
+    }
+
+    if (static_cast<juce::int32>(liveWaitingUntilMs - now) > 0)
+        return static_cast<int>(liveWaitingUntilMs - now);
+
+    // Backlog waits for enough budget to cover the chunk (or a full bucket),
+    // which bounds the debt a live chunk can find in front of it
+    auto needed = juce::jmin(size, bytesPerMs * burstMs);
+    if (tokens >= needed)
+    {
+        tokens -= size;
+        return 0;
+    }
+
+    return 1 + static_cast<int>((needed - tokens) / bytesPerMs);
+}
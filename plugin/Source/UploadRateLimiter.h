@@ -0,0 +1,42 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Token bucket for the network sinks, so uploads stay under a rate the user
+// picks and leave room for the DAW's own network use (sample libraries,
+// collaboration). Live chunks always come first: while one is waiting,
+// backlog chunks (replayed after an outage) are refused, so the backlog only
+// ever spends budget live audio isn't using.
+class UploadRateLimiter
+{
+public:
+    enum class Priority
+    {
+        live,
+        backlog
+    };
+
+    // 0 removes the limit
+    void setRateKbps(int kbps);
+    int getRateKbps() const { return rateKbps.load(); }
+
+    // Never blocks. Returns 0 and takes the tokens if numBytes may go out now,
+    // otherwise roughly how many milliseconds to wait before asking again.
+    int tryAcquire(size_t numBytes, Priority priority);
+
+private:
+    void refill(juce::uint32 now);
+
+    // A full bucket lets this much traffic through at once
+    static constexpr double burstMs = 1000.0;
+    // Live requests are re-asked well within this, so backlog stays held while any wait
+    static constexpr juce::uint32 liveHoldMs = 100;
+
+    std::atomic<int> rateKbps{ 0 };
+
+    juce::CriticalSection lock;
+    double bytesPerMs = 0.0;
+    double tokens = 0.0;  // bytes; negative after a chunk larger than the burst
+    juce::uint32 lastRefillMs = 0;
+    juce::uint32 liveWaitingUntilMs = 0;
+};
@@ -0,0 +1,257 @@
+#include "UploadSink.h"
+
+UploadSink::UploadSink(const juce::String& sinkName)
+    : juce::Thread("Auxlee Sink " + sinkName),
+      name(sinkName)
+{
+    startThread();
+}
+
+UploadSink::~UploadSink()
+{
+    jassert(!isThreadRunning());  // derived class forgot to call shutdown()
+}
+
+void UploadSink::shutdown()
+{
+    stopThread(6000);
+    pool.removeAllJobs(false, 6000);
+}
+
+void UploadSink::beginSession()
+{
+    {
+        juce::ScopedLock lock(queueLock);
+        liveQueue.clear();
+        backlogQueue.clear();
+        queuedBytes = 0;
+        ++sessionSerial;  // deliveries still in flight for the old session are forgotten when they finish
+    }
+
+    chunksSent = 0;
+    chunksFailed = 0;
+    chunksDropped = 0;
+    consecutiveFailures = 0;
+    retryAtMs = 0;
+
+    sessionStarted();
+}
+
+bool UploadSink::enqueue(std::shared_ptr<const EncodedChunk> chunk)
+{
+    {
+        juce::ScopedLock lock(queueLock);
+        auto size = static_cast<juce::int64>(chunk->data.getSize());
+
+        if (queuedBytes + size > maxQueuedBytes)
+        {
+            ++chunksDropped;
+            return false;
+        }
+
+        queuedBytes += size;
+        liveQueue.push_back({ std::move(chunk), 0, sessionSerial.load(), juce::Time::getMillisecondCounter() });
+    }
+
+    notify();
+    return true;
+}
+
+bool UploadSink::waitForSpace(int timeoutMs)
+{
+    auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(timeoutMs);
+
+    for (;;)
+    {
+        {
+            juce::ScopedLock lock(queueLock);
+            if (queuedBytes < maxQueuedBytes / 2)
+                return true;
+        }
+
+        if (!isHealthy() || juce::Time::getMillisecondCounter() >= deadline)
+            return false;
+
+        spaceFreed.wait(50);
+    }
+}
+
+int UploadSink::getNumPending() const
+{
+    juce::ScopedLock lock(queueLock);
+    return static_cast<int>(liveQueue.size() + backlogQueue.size()) + deliveriesInFlight.load();
+}
+
+void UploadSink::dropPendingChunks()
+{
+    {
+        juce::ScopedLock lock(queueLock);
+        chunksDropped += static_cast<int>(liveQueue.size() + backlogQueue.size());
+        liveQueue.clear();
+        backlogQueue.clear();
+        queuedBytes = 0;
+        ++sessionSerial;
+    }
+
+    spaceFreed.signal();
+}
+
+UploadSink::Status UploadSink::getStatus() const
+{
+    Status status;
+    status.name = name;
+    status.healthy = isHealthy();
+    {
+        juce::ScopedLock lock(queueLock);
+        status.backlogChunks = static_cast<int>(backlogQueue.size());
+        status.queuedChunks = static_cast<int>(liveQueue.size()) + status.backlogChunks;
+    }
+    status.chunksSent = chunksSent.load();
+    status.chunksFailed = chunksFailed.load();
+    status.chunksDropped = chunksDropped.load();
+    status.lastUploadMs = lastUploadMs.load();
+    return status;
+}
+
+void UploadSink::run()
+{
+    while (!threadShouldExit())
+    {
+        // Backing off after failures; other sinks carry on meanwhile
+        auto retryAt = retryAtMs.load();
+        if (retryAt != 0 && juce::Time::getMillisecondCounter() < retryAt)
+        {
+            wait(50);
+            continue;
+        }
+
+        QueuedChunk queued;
+        bool isLive = false;
+        int waitMs = 20;
+        {
+            juce::ScopedLock lock(queueLock);
+            takeNextChunk(queued, isLive, waitMs);
+        }
+
+        if (queued.chunk == nullptr)
+        {
+            wait(juce::jlimit(1, 20, waitMs));
+            continue;
+        }
+
+        ++deliveriesInFlight;
+        if (isLive)
+            ++liveDeliveriesInFlight;
+
+        pool.addJob([this, queued, isLive]
+        {
+            auto start = juce::Time::getMillisecondCounter();
+            auto result = deliver(*queued.chunk);
+            deliveryFinished(queued, isLive, result, static_cast<int>(juce::Time::getMillisecondCounter() - start));
+        });
+    }
+}
+
+bool UploadSink::takeNextChunk(QueuedChunk& next, bool& isLive, int& waitMs)
+{
+    auto now = juce::Time::getMillisecondCounter();
+    while (!liveQueue.empty() && now - liveQueue.front().queuedAtMs > liveWindowMs)
+    {
+        backlogQueue.push_back(std::move(liveQueue.front()));
+        liveQueue.pop_front();
+    }
+
+    // Live chunks get their own slots; backlog only goes out with no live chunk waiting
+    auto maxDeliveries = maxParallelDeliveries.load();
+    std::deque<QueuedChunk>* source = nullptr;
+
+    if (!liveQueue.empty())
+    {
+        if (liveDeliveriesInFlight.load() < maxDeliveries)
+            source = &liveQueue;
+    }
+    else if (!backlogQueue.empty() && deliveriesInFlight.load() < maxDeliveries)
+    {
+        source = &backlogQueue;
+    }
+
+    if (source == nullptr)
+        return false;
+
+    if (auto* limiter = rateLimiter.load())
+    {
+        waitMs = limiter->tryAcquire(source->front().chunk->data.getSize(),
+                                     source == &liveQueue ? UploadRateLimiter::Priority::live
+                                                          : UploadRateLimiter::Priority::backlog);
+        if (waitMs > 0)
+            return false;
+    }
+
+    next = std::move(source->front());
+    source->pop_front();
+    isLive = source == &liveQueue;
+    return true;
+}
+
+void UploadSink::deliveryFinished(QueuedChunk queued, bool isLive, DeliveryResult result, int elapsedMs)
+{
+    lastUploadMs = elapsedMs;
+
+    if (isLive)
+        --liveDeliveriesInFlight;
+
+    if (queued.sessionSerial != sessionSerial.load())
+    {
+        --deliveriesInFlight;
+        notify();
+        return;
+    }
+
+    if (result == DeliveryResult::delivered)
+    {
+        ++chunksSent;
+        consecutiveFailures = 0;
+        retryAtMs = 0;
+
+        juce::ScopedLock lock(queueLock);
+        queuedBytes -= static_cast<juce::int64>(queued.chunk->data.getSize());
+    }
+    else if (result == DeliveryResult::failed)
+    {
+        ++chunksFailed;
+        auto failures = ++consecutiveFailures;
+
+        // Back off 0.5 s, 1 s, 2 s ... up to 30 s before the next attempt
+        auto backoffMs = juce::jmin(30000, 500 << juce::jmin(failures - 1, 6));
+        retryAtMs = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(backoffMs);
+
+        // An outage can outlast any retry count, so the chunk waits it out; the
+        // backend orders chunks by index, so sending out of order is safe
+        juce::ScopedLock lock(queueLock);
+        backlogQueue.push_front(std::move(queued));
+    }
+    else
+    {
+        // The destination is up, so the others carry on; this chunk goes to the back
+        ++chunksFailed;
+        consecutiveFailures = 0;
+        retryAtMs = 0;
+
+        juce::ScopedLock lock(queueLock);
+        if (++queued.attempts < maxAttempts)
+        {
+            backlogQueue.push_back(std::move(queued));
+        }
+        else
+        {
+            ++chunksDropped;
+            queuedBytes -= static_cast<juce::int64>(queued.chunk->data.getSize());
+            DBG(name + ": giving up on take " + juce::String(queued.chunk->info.take)
+                + " chunk " + juce::String(queued.chunk->info.index));
+        }
+    }
+
+    --deliveriesInFlight;
+    spaceFreed.signal();
+    notify();
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "NetworkClient.h"
+#include "UploadRateLimiter.h"
+
+// A chunk after encoding, shared by every sink it is sent to
+struct EncodedChunk
+{
+    juce::MemoryBlock data;
+    ChunkInfo info;
+    bool isOgg = false;
+};
+
+// One destination for encoded chunks with its own bounded queue and thread,
+// so a slow or unreachable destination never holds up capture or the other
+// destinations. Failed deliveries go back to the front of the queue and are
+// retried with backoff for as long as the session lasts; after a few failures
+// in a row the sink reports itself unhealthy until a delivery succeeds again.
+// Only a chunk the destination rejects outright is given up on, after a few
+// attempts.
+//
+// Chunks are live while fresh and become backlog once they've failed or
+// waited longer than a few chunks' worth (an outage, or a link slower than
+// the audio). Live chunks are always sent first, with one delivery slot of
+// their own, so draining a backlog never delays what's being recorded now.
+class UploadSink : private juce::Thread
+{
+public:
+    struct Status
+    {
+        juce::String name;
+        bool healthy = true;
+        int queuedChunks = 0;
+        int backlogChunks = 0;  // of those, ones no longer live
+        int chunksSent = 0;
+        int chunksFailed = 0;   // attempts that failed, including ones retried later
+        int chunksDropped = 0;  // queue full or rejected too often
+        int lastUploadMs = 0;
+    };
+
+    explicit UploadSink(const juce::String& sinkName);
+    ~UploadSink() override;
+
+    const juce::String& getName() const { return name; }
+
+    // Message thread, between sessions: forgets the previous session's state
+    void beginSession();
+
+    // Never blocks; returns false (and counts a drop) when the queue is full
+    bool enqueue(std::shared_ptr<const EncodedChunk> chunk);
+    // For offline renders, which may wait for a healthy sink to catch up
+    bool waitForSpace(int timeoutMs);
+    // Chunks queued or in flight; 0 once everything was delivered or given up on
+    int getNumPending() const;
+
+    // Once nothing is pending (or waiting for that timed out): closes the
+    // session at the destination. takes is filled in by destinations that
+    // can report what they assembled.
+    virtual bool finishSession(juce::Array<FinalizedTake>& takes) = 0;
+
+    // Several deliveries in flight at once while bouncing, one at a time live
+    void setMaxParallelDeliveries(int maxDeliveries) { maxParallelDeliveries = juce::jlimit(1, maxPoolThreads, maxDeliveries); }
+
+    // Optional shared bandwidth budget; the limiter must outlive the sink
+    void setRateLimiter(UploadRateLimiter* limiter) { rateLimiter = limiter; }
+
+    bool isHealthy() const { return consecutiveFailures.load() < failuresBeforeUnhealthy; }
+    Status getStatus() const;
+
+protected:
+    enum class DeliveryResult
+    {
+        delivered,
+        failed,    // destination unreachable or overloaded; says nothing about the chunk
+        rejected   // destination refused this chunk
+    };
+
+    // Called on pool threads, possibly several at once
+    virtual DeliveryResult deliver(const EncodedChunk& chunk) = 0;
+    virtual void sessionStarted() {}
+
+    // Derived destructors must call this before their members go away
+    void shutdown();
+    // Forgets everything still queued, counting it as dropped; deliveries in
+    // flight are ignored when they finish. For destinations that can't take
+    // chunks once their session is closed.
+    void dropPendingChunks();
+
+private:
+    struct QueuedChunk
+    {
+        std::shared_ptr<const EncodedChunk> chunk;
+        int attempts = 0;  // rejected ones
+        int sessionSerial = 0;
+        juce::uint32 queuedAtMs = 0;
+    };
+
+    void run() override;
+    // Under queueLock: the next chunk allowed out now, if any
+    bool takeNextChunk(QueuedChunk& next, bool& isLive, int& waitMs);
+    void deliveryFinished(QueuedChunk queued, bool isLive, DeliveryResult result, int elapsedMs);
+
+    static constexpr int maxPoolThreads = 4;
+    static constexpr int failuresBeforeUnhealthy = 3;
+    static constexpr int maxAttempts = 5;
+    static constexpr juce::int64 maxQueuedBytes = 64 * 1024 * 1024;
+    static constexpr juce::uint32 liveWindowMs = 5000;
+
+    juce::String name;
+    juce::ThreadPool pool{ maxPoolThreads };
+
+    juce::CriticalSection queueLock;
+    std::deque<QueuedChunk> liveQueue;
+    std::deque<QueuedChunk> backlogQueue;
+    juce::int64 queuedBytes = 0;   // queued plus in flight
+    juce::WaitableEvent spaceFreed;
+    std::atomic<int> sessionSerial{ 0 };
+
+    std::atomic<int> maxParallelDeliveries{ 1 };
+    std::atomic<int> deliveriesInFlight{ 0 };
+    std::atomic<int> liveDeliveriesInFlight{ 0 };
+    std::atomic<UploadRateLimiter*> rateLimiter{ nullptr };
+    std::atomic<int> consecutiveFailures{ 0 };
+    std::atomic<juce::uint32> retryAtMs{ 0 };
+
+    std::atomic<int> chunksSent{ 0 };
+    std::atomic<int> chunksFailed{ 0 };
+    std::atomic<int> chunksDropped{ 0 };
+    std::atomic<int> lastUploadMs{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(UploadSink)
+};
@@ -0,0 +1,158 @@
+#include "WaveformView.h"
+
+WaveformView::WaveformView()
+{
+    setOpaque(true);
+}
+
+WaveformView::~WaveformView()
+{
+}
+
+void WaveformView::clear()
+{
+    levels.clear();
+    totalFrames = 0;
+    playPosition = 0;
+    repaint();
+}
+
+int WaveformView::frameToX(juce::int64 frame) const
+{
+    return totalFrames > 0 ? static_cast<int>(frame * getWidth() / totalFrames) : 0;
+}
+
+void WaveformView::setPlayPosition(juce::int64 frame)
+{
+    // Only repaint when the cursor actually moves a pixel
+    if (frameToX(frame) != frameToX(playPosition))
+    {
+        playPosition = frame;
+        repaint();
+    }
+    else
+    {
+        playPosition = frame;
+    }
+}
+
+void WaveformView::mouseDown(const juce::MouseEvent& event)
+{
+    if (totalFrames > 0 && getWidth() > 0 && onSeek != nullptr)
+        onSeek(juce::jlimit(static_cast<juce::int64>(0), totalFrames, static_cast<juce::int64>(event.x) * totalFrames / getWidth()));
+}
+
+void WaveformView::mouseDrag(const juce::MouseEvent& event)
+{
+    mouseDown(event);
+}
+
+bool WaveformView::setPeakData(const juce::MemoryBlock& data)
+{
+    clear();
+
+    juce::MemoryInputStream input(data, false);
+
+    char magic[4] = {};
+    if (input.read(magic, 4) != 4 || juce::String(magic, 4) != "AXPK")
+        return false;
+
+    auto version = input.readShort();
+    auto numLevels = input.readShort();
+    input.readInt();  // sample rate
+    totalFrames = input.readInt64();
+    auto baseBucketFrames = static_cast<juce::int64>(input.readInt());
+    auto levelFactor = static_cast<juce::int64>(input.readInt());
+
+    if (version != 1 || numLevels <= 0 || baseBucketFrames <= 0 || levelFactor <= 1)
+    {
+        totalFrames = 0;
+        return false;
+    }
+
+    auto framesPerBucket = baseBucketFrames;
+
+    for (int i = 0; i < numLevels; ++i)
+    {
+        Level level;
+        level.framesPerBucket = framesPerBucket;
+        level.numBuckets = input.readInt();
+
+        auto numBytes = static_cast<size_t>(level.numBuckets) * 2;
+        if (level.numBuckets < 0 || static_cast<juce::int64>(numBytes) > input.getNumBytesRemaining())
+        {
+            clear();
+            return false;
+        }
+
+        level.minMax.malloc(numBytes);
+        input.read(level.minMax.get(), static_cast<int>(numBytes));
+
+        levels.push_back(std::move(level));
+        framesPerBucket *= levelFactor;
+    }
+
+    repaint();
+    return true;
+}
+
+const WaveformView::Level* WaveformView::chooseLevel(double framesPerPixel) const
+{
+    // Coarsest level that still has at least one bucket per pixel
+    const Level* best = levels.empty() ? nullptr : &levels.front();
+
+    for (auto& level : levels)
+    {
+        if (static_cast<double>(level.framesPerBucket) <= framesPerPixel)
+            best = &level;
+    }
+
+    return best;
+}
+
+void WaveformView::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    auto width = getWidth();
+    auto* level = chooseLevel(static_cast<double>(totalFrames) / juce::jmax(1, width));
+
+    if (level == nullptr || level->numBuckets == 0 || totalFrames <= 0)
+    {
+        g.setColour(juce::Colours::grey);
+        g.drawFittedText("No waveform", getLocalBounds(), juce::Justification::centred, 1);
+        return;
+    }
+
+    auto centre = getHeight() * 0.5f;
+    auto scale = centre / 128.0f;
+    auto bucketsPerPixel = static_cast<double>(level->numBuckets) / width;
+
+    g.setColour(juce::Colours::lightgreen);
+
+    for (int x = 0; x < width; ++x)
+    {
+        auto first = static_cast<int>(x * bucketsPerPixel);
+        auto last = juce::jlimit(first + 1, level->numBuckets, static_cast<int>((x + 1) * bucketsPerPixel));
+
+        if (first >= level->numBuckets)
+            break;
+
+        int minValue = 127;
+        int maxValue = -128;
+
+        for (int bucket = first; bucket < last; ++bucket)
+        {
+            minValue = juce::jmin(minValue, static_cast<int>(level->minMax[bucket * 2]));
+            maxValue = juce::jmax(maxValue, static_cast<int>(level->minMax[bucket * 2 + 1]));
+        }
+
+        g.drawVerticalLine(x, centre - maxValue * scale, centre - minValue * scale + 1.0f);
+    }
+
+    if (playPosition > 0 && playPosition < totalFrames)
+    {
+        g.setColour(juce::Colours::white);
+        g.drawVerticalLine(frameToX(playPosition), 0.0f, static_cast<float>(getHeight()));
+    }
+}
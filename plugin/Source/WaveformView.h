@@ -0,0 +1,44 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Draws a track overview from the server's min/max peak pyramid
+// (see backend/peaks.py). Each pixel reads a few buckets from the level
+// closest to its width, so painting costs the same for any track length.
+// Clicking or dragging seeks; the play position is drawn as a cursor.
+class WaveformView : public juce::Component
+{
+public:
+    WaveformView();
+    ~WaveformView() override;
+
+    bool setPeakData(const juce::MemoryBlock& data);
+    void clear();
+
+    juce::int64 getTotalFrames() const { return totalFrames; }
+    void setPlayPosition(juce::int64 frame);
+
+    // Called with the take frame under the mouse
+    std::function<void(juce::int64)> onSeek;
+
+    void paint(juce::Graphics&) override;
+    void mouseDown(const juce::MouseEvent&) override;
+    void mouseDrag(const juce::MouseEvent&) override;
+
+private:
+    struct Level
+    {
+        juce::int64 framesPerBucket = 0;
+        int numBuckets = 0;
+        juce::HeapBlock<juce::int8> minMax;  // interleaved min, max
+    };
+
+    const Level* chooseLevel(double framesPerPixel) const;
+    int frameToX(juce::int64 frame) const;
+
+    std::vector<Level> levels;
+    juce::int64 totalFrames = 0;
+    juce::int64 playPosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformView)
+};
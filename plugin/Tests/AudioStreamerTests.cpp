@@ -0,0 +1,138 @@
+#include "AudioStreamer.h"
+#include "TestSinks.h"
+
+// Chunk contents must depend only on the audio, never on how the host sliced
+// it into blocks: the capture stage regroups whatever arrives into fixed
+// frames, so every block-size pattern has to produce the same chunks.
+class AudioStreamerTests : public juce::UnitTest
+{
+public:
+    AudioStreamerTests()
+        : juce::UnitTest("AudioStreamer", "Auxlee")
+    {
+    }
+
+    void runTest() override
+    {
+        constexpr int numChannels = 2;
+        constexpr int totalSamples = 48000 * 9;
+
+        juce::Random random(0x5eed);
+        juce::AudioBuffer<float> signal(numChannels, totalSamples);
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < totalSamples; ++i)
+                signal.setSample(channel, i, random.nextFloat() - 0.5f);
+
+        beginTest("Fixed blocks reproduce the input");
+        auto reference = capture(signal, [](juce::Random&) { return 512; }, true);
+        expectEquals(static_cast<int>(reference.samples.size()), totalSamples * numChannels);
+        expect(reference.samples == interleave(signal), "captured audio differs from the input");
+
+        // A pause longer than the silence hold is gated out frame by frame,
+        // which splits the chunks where the timeline jumps
+        auto withPause = signal;
+        for (int channel = 0; channel < numChannels; ++channel)
+            withPause.clear(channel, 48000 * 3 + 100, 48000 * 2);
+
+        auto pausedReference = capture(withPause, [](juce::Random&) { return 512; }, true);
+        expectLessThan(static_cast<int>(pausedReference.samples.size()), totalSamples * numChannels);
+
+        beginTest("Random block sizes give identical chunks");
+        for (int run = 0; run < 4; ++run)
+        {
+            // Includes single samples and blocks far larger than the prepared size
+            auto blockSizes = [](juce::Random& r) { return r.nextInt(2) == 0 ? 1 + r.nextInt(64) : 1 + r.nextInt(8192); };
+
+            auto fuzzed = capture(signal, blockSizes, true);
+            expect(fuzzed.chunkSizes == reference.chunkSizes, "chunk boundaries moved with the block size");
+            expect(fuzzed.samples == reference.samples, "chunk contents changed with the block size");
+
+            auto fuzzedPause = capture(withPause, blockSizes, true);
+            expect(fuzzedPause.chunkSizes == pausedReference.chunkSizes, "silence gating moved with the block size");
+            expect(fuzzedPause.samples == pausedReference.samples, "silence gating changed with the block size");
+        }
+
+        beginTest("Regrouping without a host position");
+        auto unpositioned = capture(signal, [](juce::Random& r) { return 1 + r.nextInt(3000); }, false);
+        expect(unpositioned.chunkSizes == reference.chunkSizes);
+        expect(unpositioned.samples == reference.samples);
+
+        beginTest("Every channel of a multichannel layout is captured");
+        juce::AudioBuffer<float> surround(6, 48000 * 3);
+        for (int channel = 0; channel < surround.getNumChannels(); ++channel)
+            for (int i = 0; i < surround.getNumSamples(); ++i)
+                surround.setSample(channel, i, random.nextFloat() - 0.5f);
+
+        auto captured = capture(surround, [](juce::Random& r) { return 1 + r.nextInt(2048); }, true);
+        expect(captured.samples == interleave(surround), "channels beyond stereo were lost");
+    }
+
+private:
+    struct Captured
+    {
+        std::vector<int> chunkSizes;  // frames per chunk, in index order
+        std::vector<float> samples;   // interleaved, all chunks in index order
+    };
+
+    template <typename BlockSizeFn>
+    Captured capture(const juce::AudioBuffer<float>& signal, BlockSizeFn nextBlockSize, bool withHostPosition)
+    {
+        CapturingSink sink;
+        AudioStreamer streamer;
+        streamer.setSinks({ &sink });
+        streamer.prepare(48000.0, 512, signal.getNumChannels());
+        streamer.setSampleFormat(AudioStreamer::SampleFormat::float32);
+        streamer.setPrerollSeconds(0.0);
+        streamer.beginSession();
+        streamer.startTake(false);
+        streamer.start();
+
+        juce::Random random(getRandom().nextInt(1 << 30));
+        for (int position = 0; position < signal.getNumSamples();)
+        {
+            auto numSamples = juce::jmin(nextBlockSize(random), signal.getNumSamples() - position);
+
+            juce::Optional<juce::int64> hostPosition;
+            if (withHostPosition)
+                hostPosition = static_cast<juce::int64>(position);
+
+            streamer.addAudioData(signal, position, numSamples, hostPosition);
+            position += numSamples;
+        }
+
+        streamer.stop();
+        expect(streamer.flush(10000), "uploads didn't drain");
+        expectEquals(static_cast<int>(streamer.getStatistics().droppedSamples), 0);
+
+        auto delivered = sink.getDelivered();
+        std::sort(delivered.begin(), delivered.end(),
+                  [](const EncodedChunk& a, const EncodedChunk& b) { return a.info.index < b.info.index; });
+
+        Captured result;
+        for (auto& chunk : delivered)
+        {
+            int chunkChannels = 0;
+            auto samples = readFloatWavChunk(chunk, chunkChannels);
+            expectEquals(chunkChannels, signal.getNumChannels());
+
+            result.chunkSizes.push_back(static_cast<int>(samples.size()) / chunkChannels);
+            result.samples.insert(result.samples.end(), samples.begin(), samples.end());
+        }
+
+        return result;
+    }
+
+    static std::vector<float> interleave(const juce::AudioBuffer<float>& signal)
+    {
+        std::vector<float> samples;
+        samples.reserve(static_cast<size_t>(signal.getNumSamples() * signal.getNumChannels()));
+
+        for (int i = 0; i < signal.getNumSamples(); ++i)
+            for (int channel = 0; channel < signal.getNumChannels(); ++channel)
+                samples.push_back(signal.getSample(channel, i));
+
+        return samples;
+    }
+};
+
+static AudioStreamerTests audioStreamerTests;
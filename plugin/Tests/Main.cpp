@@ -0,0 +1,14 @@
+#include <JuceHeader.h>
+
+// Runs every registered juce::UnitTest; a non-zero exit code fails ctest
+int main()
+{
+    juce::UnitTestRunner runner;
+    runner.runAllTests();
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,191 @@
+#include "SampleKernels.h"
+
+// Every kernel select() hands out, the SIMD ones included, must write exactly
+// what a plain per-sample conversion does: clipped, truncated towards zero,
+// little-endian, for any length including the tails the vector loops leave.
+class SampleKernelsTests : public juce::UnitTest
+{
+public:
+    SampleKernelsTests()
+        : juce::UnitTest("SampleKernels", "Auxlee")
+    {
+    }
+
+    void runTest() override
+    {
+        using Format = SampleKernels::Format;
+        const Format formats[] = { Format::int16, Format::int24, Format::float32 };
+        const int channelCounts[] = { 1, 2, 3, 6, 8 };
+
+        beginTest("Every kernel matches the reference conversion");
+        {
+            juce::Random random(getRandom().nextInt(1 << 30));
+
+            for (auto format : formats)
+            {
+                for (auto numChannels : channelCounts)
+                {
+                    auto kernel = SampleKernels::select(numChannels, format);
+
+                    // Every length up to a few vectors, then some long odd ones
+                    for (int numSamples = 0; numSamples < 40 + 1000; numSamples += numSamples < 40 ? 1 : 333)
+                    {
+                        auto channels = makeSignal(random, numChannels, numSamples);
+                        auto expected = reference(channels, numSamples, format);
+
+                        // Guard bytes catch writes past the end
+                        std::vector<juce::uint8> written(expected.size() + 16, 0xa5);
+                        kernel(pointers(channels).data(), numChannels, numSamples, written.data());
+
+                        bool matches = std::equal(expected.begin(), expected.end(), written.begin());
+                        bool guardIntact = std::all_of(written.begin() + static_cast<std::ptrdiff_t>(expected.size()), written.end(),
+                                                       [](juce::uint8 b) { return b == 0xa5; });
+
+                        auto description = juce::String(formatName(format)) + ", " + juce::String(numChannels)
+                                         + " channel(s), " + juce::String(numSamples) + " frames";
+                        expect(matches, "wrong output for " + description);
+                        expect(guardIntact, "wrote past the end for " + description);
+                    }
+                }
+            }
+        }
+
+        beginTest("Clipping at and beyond full scale");
+        {
+            for (auto format : { Format::int16, Format::int24 })
+            {
+                for (auto numChannels : { 1, 2 })
+                {
+                    // Long enough for the vector loops, with the edge cases in every lane
+                    const float edges[] = { 1.0f, -1.0f, 1.5f, -1.5f, 100.0f, -100.0f, 0.99999f, -0.99999f };
+                    std::vector<std::vector<float>> channels(static_cast<size_t>(numChannels));
+                    for (auto& channel : channels)
+                        for (int i = 0; i < 64; ++i)
+                            channel.push_back(edges[i % 8]);
+
+                    std::vector<juce::uint8> written(reference(channels, 64, format).size());
+                    SampleKernels::select(numChannels, format)(pointers(channels).data(), numChannels, 64, written.data());
+
+                    auto bytesPerSample = SampleKernels::getBytesPerSample(format);
+                    auto fullScale = format == Format::int16 ? 32767 : 8388607;
+
+                    for (int i = 0; i < 64 * numChannels; ++i)
+                    {
+                        auto value = readInt(written.data() + i * bytesPerSample, bytesPerSample);
+                        auto edge = edges[(i / numChannels) % 8];
+                        if (std::abs(edge) >= 1.0f)
+                            expectEquals(value, edge > 0.0f ? fullScale : -fullScale, juce::String(formatName(format)) + " didn't clip");
+                    }
+                }
+            }
+        }
+
+        beginTest("Throughput per kernel");
+        {
+            constexpr int numSamples = 4096, numBlocks = 200;
+            juce::Random random(42);
+
+            for (auto format : formats)
+            {
+                for (auto numChannels : { 1, 2, 6 })
+                {
+                    auto kernel = SampleKernels::select(numChannels, format);
+                    auto channels = makeSignal(random, numChannels, numSamples);
+                    auto channelPointers = pointers(channels);
+                    std::vector<juce::uint8> dest(static_cast<size_t>(numSamples * numChannels * SampleKernels::getBytesPerSample(format)));
+
+                    auto start = juce::Time::getMillisecondCounterHiRes();
+                    for (int block = 0; block < numBlocks; ++block)
+                        kernel(channelPointers.data(), numChannels, numSamples, dest.data());
+                    auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - start;
+
+                    auto nsPerSample = elapsedMs * 1.0e6 / (static_cast<double>(numSamples) * numBlocks * numChannels);
+                    logMessage(juce::String::formatted("%-7s %d ch: %6.2f ns/sample", formatName(format), numChannels, nsPerSample));
+                    expect(dest[0] != 0xff || dest[1] != 0xff);  // keeps the work from being optimized away
+                }
+            }
+        }
+    }
+
+private:
+    // Mostly in range, with some out-of-range samples that have to be clipped
+    static std::vector<std::vector<float>> makeSignal(juce::Random& random, int numChannels, int numSamples)
+    {
+        std::vector<std::vector<float>> channels(static_cast<size_t>(numChannels));
+        for (auto& channel : channels)
+            for (int i = 0; i < numSamples; ++i)
+                channel.push_back((random.nextFloat() * 2.0f - 1.0f) * (random.nextInt(8) == 0 ? 3.0f : 1.0f));
+
+        return channels;
+    }
+
+    static std::vector<const float*> pointers(const std::vector<std::vector<float>>& channels)
+    {
+        std::vector<const float*> result;
+        for (auto& channel : channels)
+            result.push_back(channel.data());
+
+        return result;
+    }
+
+    static std::vector<juce::uint8> reference(const std::vector<std::vector<float>>& channels, int numSamples, SampleKernels::Format format)
+    {
+        std::vector<juce::uint8> bytes;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            for (auto& channel : channels)
+            {
+                auto sample = channel[static_cast<size_t>(i)];
+                auto clipped = sample < -1.0f ? -1.0f : (sample > 1.0f ? 1.0f : sample);
+
+                if (format == SampleKernels::Format::float32)
+                {
+                    juce::uint32 bits;
+                    std::memcpy(&bits, &sample, sizeof(bits));
+                    appendLittleEndian(bytes, static_cast<juce::int64>(bits), 4);
+                }
+                else if (format == SampleKernels::Format::int24)
+                {
+                    appendLittleEndian(bytes, static_cast<juce::int64>(clipped * 8388607.0f), 3);
+                }
+                else
+                {
+                    appendLittleEndian(bytes, static_cast<juce::int64>(clipped * 32767.0f), 2);
+                }
+            }
+        }
+
+        return bytes;
+    }
+
+    static void appendLittleEndian(std::vector<juce::uint8>& bytes, juce::int64 value, int numBytes)
+    {
+        for (int i = 0; i < numBytes; ++i)
+            bytes.push_back(static_cast<juce::uint8>(value >> (8 * i)));
+    }
+
+    static int readInt(const juce::uint8* bytes, int numBytes)
+    {
+        juce::uint32 value = 0;
+        for (int i = 0; i < numBytes; ++i)
+            value |= static_cast<juce::uint32>(bytes[i]) << (8 * i);
+
+        // Sign-extend from the sample width
+        auto shift = 32 - 8 * numBytes;
+        return static_cast<juce::int32>(value << shift) >> shift;
+    }
+
+    static const char* formatName(SampleKernels::Format format)
+    {
+        switch (format)
+        {
+            case SampleKernels::Format::int24:   return "int24";
+            case SampleKernels::Format::float32: return "float32";
+            case SampleKernels::Format::int16:
+            default:                             return "int16";
+        }
+    }
+};
+
+static SampleKernelsTests sampleKernelsTests;
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "UploadSink.h"
+#include "Crc32.h"
+
+// Stand-in destination that keeps every delivered chunk in memory, in the
+// order deliveries completed
+class CapturingSink : public UploadSink
+{
+public:
+    explicit CapturingSink(const juce::String& sinkName = "Capture")
+        : UploadSink(sinkName)
+    {
+    }
+
+    ~CapturingSink() override
+    {
+        shutdown();
+    }
+
+    std::vector<EncodedChunk> getDelivered() const
+    {
+        juce::ScopedLock lock(deliveredLock);
+        return delivered;
+    }
+
+    int getNumDelivered() const
+    {
+        juce::ScopedLock lock(deliveredLock);
+        return static_cast<int>(delivered.size());
+    }
+
+    bool finishSession(juce::Array<FinalizedTake>& takes) override
+    {
+        juce::ignoreUnused(takes);
+        return getNumDelivered() > 0;
+    }
+
+protected:
+    DeliveryResult deliver(const EncodedChunk& chunk) override
+    {
+        juce::ScopedLock lock(deliveredLock);
+        delivered.push_back(chunk);
+        return DeliveryResult::delivered;
+    }
+
+private:
+    juce::CriticalSection deliveredLock;
+    std::vector<EncodedChunk> delivered;
+};
+
+// Stand-in server: reports each take's chunk count and chunk hash the way the
+// backend computes them at finalize, from whatever it actually received
+class AssemblingSink : public CapturingSink
+{
+public:
+    // chunkToLose is acknowledged but never kept, like a server losing it
+    explicit AssemblingSink(const juce::String& sinkName, int chunkToLose = -1)
+        : CapturingSink(sinkName),
+          lostIndex(chunkToLose)
+    {
+    }
+
+    bool finishSession(juce::Array<FinalizedTake>& takes) override
+    {
+        auto delivered = getDelivered();
+        std::sort(delivered.begin(), delivered.end(), [](const EncodedChunk& a, const EncodedChunk& b)
+        {
+            return a.info.take != b.info.take ? a.info.take < b.info.take : a.info.index < b.info.index;
+        });
+
+        for (auto& chunk : delivered)
+        {
+            if (takes.isEmpty() || takes.getReference(takes.size() - 1).take != chunk.info.take)
+            {
+                FinalizedTake take;
+                take.take = chunk.info.take;
+                takes.add(take);
+            }
+
+            auto& take = takes.getReference(takes.size() - 1);
+            juce::uint8 crcBytes[4];
+            juce::ByteOrder::writeLittleEndianInt(crcBytes, chunk.info.crc32);
+            take.chunkHash = Crc32::compute(crcBytes, sizeof(crcBytes), take.chunkHash);
+            ++take.numChunks;
+        }
+
+        return !takes.isEmpty();
+    }
+
+protected:
+    DeliveryResult deliver(const EncodedChunk& chunk) override
+    {
+        return chunk.info.index == lostIndex ? DeliveryResult::delivered : CapturingSink::deliver(chunk);
+    }
+
+private:
+    const int lostIndex;
+};
+
+// Stand-in for a server that is down: every delivery fails
+class FailingSink : public UploadSink
+{
+public:
+    explicit FailingSink(const juce::String& sinkName)
+        : UploadSink(sinkName)
+    {
+    }
+
+    ~FailingSink() override
+    {
+        shutdown();
+    }
+
+    bool finishSession(juce::Array<FinalizedTake>& takes) override
+    {
+        juce::ignoreUnused(takes);
+        return false;
+    }
+
+protected:
+    DeliveryResult deliver(const EncodedChunk& chunk) override
+    {
+        juce::ignoreUnused(chunk);
+        juce::Thread::sleep(5);
+        return DeliveryResult::failed;
+    }
+};
+
+// Stand-in server that answers from a script, given the chunk and how many
+// times it was attempted before; whatever it accepts is kept
+class ScriptedSink : public CapturingSink
+{
+public:
+    using UploadSink::DeliveryResult;
+    using Script = std::function<DeliveryResult(const EncodedChunk& chunk, int previousAttempts)>;
+
+    ScriptedSink(const juce::String& sinkName, Script scriptToUse)
+        : CapturingSink(sinkName),
+          script(std::move(scriptToUse))
+    {
+    }
+
+    int getNumAttempts(int index) const
+    {
+        juce::ScopedLock lock(attemptsLock);
+        auto found = attempts.find(index);
+        return found != attempts.end() ? found->second : 0;
+    }
+
+protected:
+    DeliveryResult deliver(const EncodedChunk& chunk) override
+    {
+        int previousAttempts = 0;
+        {
+            juce::ScopedLock lock(attemptsLock);
+            previousAttempts = attempts[chunk.info.index]++;
+        }
+
+        auto result = script(chunk, previousAttempts);
+        return result == DeliveryResult::delivered ? CapturingSink::deliver(chunk) : result;
+    }
+
+private:
+    const Script script;
+    mutable juce::CriticalSection attemptsLock;
+    std::map<int, int> attempts;
+};
+
+// Interleaved samples of a 32-bit float WAV chunk as AudioStreamer encodes it
+inline std::vector<float> readFloatWavChunk(const EncodedChunk& chunk, int& numChannels)
+{
+    constexpr size_t headerSize = 44;
+    auto* bytes = static_cast<const char*>(chunk.data.getData());
+
+    numChannels = static_cast<int>(juce::ByteOrder::littleEndianShort(bytes + 22));
+    auto dataSize = juce::ByteOrder::littleEndianInt(bytes + 40);
+
+    std::vector<float> samples(dataSize / sizeof(float));
+    std::memcpy(samples.data(), bytes + headerSize, samples.size() * sizeof(float));
+    return samples;
+}
@@ -0,0 +1,99 @@
+#include "UploadRateLimiter.h"
+
+// The bucket holds a second of traffic; live chunks may run it into debt and
+// hold backlog off while they wait, backlog only ever spends what's there.
+class UploadRateLimiterTests : public juce::UnitTest
+{
+public:
+    UploadRateLimiterTests()
+        : juce::UnitTest("UploadRateLimiter", "Auxlee")
+    {
+    }
+
+    void runTest() override
+    {
+        using Priority = UploadRateLimiter::Priority;
+
+        beginTest("No limit");
+        {
+            UploadRateLimiter limiter;
+            expectEquals(limiter.tryAcquire(1 << 30, Priority::live), 0);
+            expectEquals(limiter.tryAcquire(1 << 30, Priority::backlog), 0);
+        }
+
+        // 80 kbps is 10 bytes per ms, with a 10000 byte bucket
+        beginTest("A full bucket lets a burst through, then live waits for the refill");
+        {
+            UploadRateLimiter limiter;
+            limiter.setRateKbps(80);
+            expectEquals(limiter.getRateKbps(), 80);
+
+            expectEquals(limiter.tryAcquire(4000, Priority::live), 0);
+            expectEquals(limiter.tryAcquire(6000, Priority::live), 0);
+
+            auto waitMs = limiter.tryAcquire(1000, Priority::live);
+            expectWithinAbsoluteError(waitMs, 1, 2);
+
+            // While a live chunk waits, backlog is held for the live hold
+            auto backlogWaitMs = limiter.tryAcquire(10, Priority::backlog);
+            expectGreaterThan(backlogWaitMs, 0);
+            expectLessOrEqual(backlogWaitMs, 100);
+        }
+
+        beginTest("A live chunk larger than the bucket goes out and leaves debt");
+        {
+            UploadRateLimiter limiter;
+            limiter.setRateKbps(80);
+
+            expectEquals(limiter.tryAcquire(25000, Priority::live), 0);
+
+            // 15000 bytes of debt take 1.5 s to pay off
+            auto waitMs = limiter.tryAcquire(100, Priority::live);
+            expectWithinAbsoluteError(waitMs, 1501, 20);
+
+            // Refilling pays the debt down at the configured rate
+            juce::Thread::sleep(300);
+            auto laterWaitMs = limiter.tryAcquire(100, Priority::live);
+            expectWithinAbsoluteError(waitMs - laterWaitMs, 300, 60);
+        }
+
+        beginTest("Backlog waits until the budget covers the whole chunk");
+        {
+            UploadRateLimiter limiter;
+            limiter.setRateKbps(80);
+
+            expectEquals(limiter.tryAcquire(6000, Priority::live), 0);
+
+            // 4000 bytes left; 5000 needs another 100 ms
+            auto waitMs = limiter.tryAcquire(5000, Priority::backlog);
+            expectWithinAbsoluteError(waitMs, 101, 10);
+            expectEquals(limiter.tryAcquire(4000, Priority::backlog), 0);
+        }
+
+        beginTest("Backlog larger than the bucket needs only a full bucket");
+        {
+            UploadRateLimiter limiter;
+            limiter.setRateKbps(80);
+
+            expectEquals(limiter.tryAcquire(30000, Priority::backlog), 0);
+
+            // That left 20000 bytes of debt in front of the next live chunk
+            expectWithinAbsoluteError(limiter.tryAcquire(100, Priority::live), 2001, 20);
+        }
+
+        beginTest("Changing the rate starts from a full bucket");
+        {
+            UploadRateLimiter limiter;
+            limiter.setRateKbps(80);
+            expectEquals(limiter.tryAcquire(25000, Priority::live), 0);
+
+            limiter.setRateKbps(160);
+            expectEquals(limiter.tryAcquire(20000, Priority::live), 0);
+
+            limiter.setRateKbps(0);
+            expectEquals(limiter.tryAcquire(1 << 30, Priority::backlog), 0);
+        }
+    }
+};
+
+static UploadRateLimiterTests uploadRateLimiterTests;
@@ -0,0 +1,274 @@
+#include "AudioStreamer.h"
+#include "TestSinks.h"
+
+// Every destination delivers from its own queue: one that is down must not
+// hold up the others, and finishing a session picks whichever destination
+// holds a verified copy.
+class UploadSinkTests : public juce::UnitTest
+{
+public:
+    UploadSinkTests()
+        : juce::UnitTest("UploadSink", "Auxlee")
+    {
+    }
+
+    void runTest() override
+    {
+        beginTest("A dead server doesn't hold up the backup");
+        {
+            FailingSink primary("Primary");
+            AssemblingSink backup("Backup");
+            auto results = record({ &primary, &backup }, 5.0);
+
+            expectEquals(results.size(), 2);
+            expect(!results[0].finished);
+            expect(results[1].finished);
+            expectEquals(results[1].numTakes, 1);
+            expectEquals(results[1].unverifiedTakes, 0);
+            expectEquals(backup.getNumDelivered(), 3);
+            expectEquals(AudioStreamer::findBestResult(results), 1);
+        }
+
+        beginTest("A server missing a chunk loses to one with a verified copy");
+        {
+            AssemblingSink primary("Primary", 1);
+            AssemblingSink backup("Backup");
+            auto results = record({ &primary, &backup }, 5.0);
+
+            expectEquals(results[0].unverifiedTakes, 1);
+            expectEquals(results[1].unverifiedTakes, 0);
+            expectEquals(AudioStreamer::findBestResult(results), 1);
+        }
+
+        using Result = ScriptedSink::DeliveryResult;
+
+        beginTest("Live chunks go out before backlog");
+        {
+            // Chunk 0 fails once and becomes backlog; 1 and 2 are still live
+            ScriptedSink sink("Primary", [](const EncodedChunk& chunk, int previousAttempts)
+            {
+                return chunk.info.index == 0 && previousAttempts == 0 ? Result::failed : Result::delivered;
+            });
+
+            sendChunks(sink, 3);
+            expect(waitUntilDone(sink, 5000), "chunks weren't delivered");
+
+            auto delivered = sink.getDelivered();
+            expectEquals(static_cast<int>(delivered.size()), 3);
+            if (delivered.size() == 3)
+            {
+                expectEquals(delivered[0].info.index, 1);
+                expectEquals(delivered[1].info.index, 2);
+                expectEquals(delivered[2].info.index, 0);
+            }
+        }
+
+        beginTest("A rejected chunk is given up on after a few attempts");
+        {
+            ScriptedSink sink("Primary", [](const EncodedChunk& chunk, int)
+            {
+                return chunk.info.index == 1 ? Result::rejected : Result::delivered;
+            });
+
+            sendChunks(sink, 3);
+            expect(waitUntilDone(sink, 5000), "the rejected chunk was retried forever");
+
+            expectEquals(sink.getNumAttempts(1), 5);
+            expectEquals(sink.getNumDelivered(), 2);
+            expectEquals(sink.getStatus().chunksDropped, 1);
+            expect(sink.isHealthy(), "a reachable server was reported unhealthy");
+        }
+
+        beginTest("Throttled live chunks stay on time while a backlog drains");
+        {
+            constexpr int backlogChunks = 30, liveChunks = 8, plugIndex = 1000, firstLiveIndex = 2000;
+            constexpr int chunkBytes = 2000, liveIntervalMs = 500;
+
+            juce::CriticalSection timesLock;
+            std::map<int, juce::uint32> deliveredAtMs;
+            juce::WaitableEvent plugArrived, releasePlug;
+
+            UploadRateLimiter limiter;
+            ScriptedSink sink("Primary", [&](const EncodedChunk& chunk, int previousAttempts)
+            {
+                auto index = chunk.info.index;
+
+                // Rejected once, each backlog chunk goes straight to the backlog
+                if (index < backlogChunks && previousAttempts == 0)
+                    return Result::rejected;
+
+                // Holds the only delivery slot until the backlog is complete
+                if (index == plugIndex)
+                {
+                    plugArrived.signal();
+                    releasePlug.wait(5000);
+                }
+
+                juce::ScopedLock lock(timesLock);
+                deliveredAtMs[index] = juce::Time::getMillisecondCounter();
+                return Result::delivered;
+            });
+            sink.setRateLimiter(&limiter);
+
+            sink.beginSession();
+            for (int index = 0; index < backlogChunks; ++index)
+                sink.enqueue(makeChunk(index, chunkBytes));
+            sink.enqueue(makeChunk(plugIndex, chunkBytes));
+
+            expect(plugArrived.wait(5000), "the backlog never formed");
+            expectEquals(sink.getStatus().backlogChunks, backlogChunks);
+
+            // 10 kB/s: live traffic takes 40 %, the backlog gets the rest
+            limiter.setRateKbps(80);
+            auto started = juce::Time::getMillisecondCounter();
+            releasePlug.signal();
+
+            std::vector<juce::uint32> enqueuedAtMs;
+            for (int i = 0; i < liveChunks; ++i)
+            {
+                enqueuedAtMs.push_back(juce::Time::getMillisecondCounter());
+                sink.enqueue(makeChunk(firstLiveIndex + i, chunkBytes));
+                juce::Thread::sleep(liveIntervalMs);
+            }
+
+            auto finished = juce::Time::getMillisecondCounter();
+            std::map<int, juce::uint32> delivered;
+            {
+                juce::ScopedLock lock(timesLock);
+                delivered = deliveredAtMs;
+            }
+
+            int backlogDelivered = 0;
+            for (auto& [index, atMs] : delivered)
+                backlogDelivered += index < backlogChunks ? 1 : 0;
+
+            for (int i = 0; i < liveChunks; ++i)
+            {
+                auto found = delivered.find(firstLiveIndex + i);
+                expect(found != delivered.end(), "live chunk " + juce::String(i) + " never went out");
+                if (found == delivered.end())
+                    continue;
+
+                // Bounded by the live window plus the limiter's live hold
+                auto latencyMs = static_cast<int>(found->second - enqueuedAtMs[(size_t) i]);
+                expectLessOrEqual(latencyMs, 5000 + 100, "live chunk " + juce::String(i) + " was late");
+
+                // Backlog never went out while this chunk waited for budget
+                for (auto& [index, atMs] : delivered)
+                {
+                    if (index < backlogChunks)
+                        expect(static_cast<juce::int32>(atMs - enqueuedAtMs[(size_t) i]) <= 20
+                                   || static_cast<juce::int32>(atMs - found->second) >= 0,
+                               "backlog chunk " + juce::String(index) + " jumped ahead of live chunk " + juce::String(i));
+                }
+            }
+
+            // The backlog drained with what the live chunks left over, and
+            // everything together stayed within the budget plus the first bucket
+            expectGreaterThan(backlogDelivered, 5);
+            auto budgetBytes = 10.0 * (finished - started) + 10000.0 + chunkBytes;
+            expectLessOrEqual((backlogDelivered + liveChunks) * chunkBytes * 1.0, budgetBytes);
+        }
+
+        beginTest("Failed deliveries are retried past the attempt limit");
+        {
+            // Five failures in a row take 7.5 s of backoff to get through
+            ScriptedSink sink("Primary", [](const EncodedChunk&, int) { return Result::failed; });
+
+            sendChunks(sink, 1);
+            auto deadline = juce::Time::getMillisecondCounter() + 12000;
+            while (sink.getNumAttempts(0) < 5 && juce::Time::getMillisecondCounter() < deadline)
+                juce::Thread::sleep(20);
+
+            juce::Thread::sleep(100);
+            expectEquals(sink.getNumAttempts(0), 5);
+            expectEquals(sink.getNumPending(), 1);
+            expectEquals(sink.getStatus().chunksDropped, 0);
+            expect(!sink.isHealthy());
+        }
+
+        beginTest("Choosing between results");
+        {
+            auto result = [](const char* name, bool finished, int numTakes, int unverifiedTakes)
+            {
+                AudioStreamer::SinkResult r;
+                r.name = name;
+                r.finished = finished;
+                r.numTakes = numTakes;
+                r.unverifiedTakes = unverifiedTakes;
+                return r;
+            };
+
+            expectEquals(AudioStreamer::findBestResult({}), -1);
+            expectEquals(AudioStreamer::findBestResult({ result("Primary", true, 2, 0), result("Backup", true, 2, 0) }), 0);
+            expectEquals(AudioStreamer::findBestResult({ result("Primary", true, 2, 1), result("Backup", true, 2, 0) }), 1);
+            expectEquals(AudioStreamer::findBestResult({ result("Local copy", true, 0, 0), result("Backup", true, 1, 1) }), 1);
+            expectEquals(AudioStreamer::findBestResult({ result("Primary", false, 0, 0), result("Local copy", true, 0, 0) }), 1);
+            expectEquals(AudioStreamer::findBestResult({ result("Primary", false, 0, 0), result("Backup", false, 0, 0) }), -1);
+        }
+    }
+
+private:
+    // Chunks 0 .. numChunks - 1 of take 0, all queued at once
+    static void sendChunks(UploadSink& sink, int numChunks)
+    {
+        sink.beginSession();
+        for (int index = 0; index < numChunks; ++index)
+            sink.enqueue(makeChunk(index, 1024));
+    }
+
+    static std::shared_ptr<const EncodedChunk> makeChunk(int index, size_t numBytes)
+    {
+        auto chunk = std::make_shared<EncodedChunk>();
+        chunk->data.setSize(numBytes, true);
+        chunk->info.index = index;
+        return chunk;
+    }
+
+    static bool waitUntilDone(const UploadSink& sink, int timeoutMs)
+    {
+        auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(timeoutMs);
+        while (sink.getNumPending() > 0)
+        {
+            if (juce::Time::getMillisecondCounter() >= deadline)
+                return false;
+
+            juce::Thread::sleep(10);
+        }
+
+        return true;
+    }
+
+    // One take of noise through the streamer, then finishes the session
+    juce::Array<AudioStreamer::SinkResult> record(const juce::Array<UploadSink*>& sinks, double seconds)
+    {
+        constexpr double sampleRate = 48000.0;
+        juce::AudioBuffer<float> block(2, 480);
+        juce::Random random(42);
+
+        AudioStreamer streamer;
+        streamer.setSinks(sinks);
+        streamer.prepare(sampleRate, block.getNumSamples(), block.getNumChannels());
+        streamer.setPrerollSeconds(0.0);
+        streamer.beginSession();
+        streamer.startTake(false);
+        streamer.start();
+
+        auto numBlocks = static_cast<int>(seconds * sampleRate) / block.getNumSamples();
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            for (int channel = 0; channel < block.getNumChannels(); ++channel)
+                for (int sample = 0; sample < block.getNumSamples(); ++sample)
+                    block.setSample(channel, sample, random.nextFloat() - 0.5f);
+
+            streamer.addAudioData(block, 0, block.getNumSamples(), static_cast<juce::int64>(i * block.getNumSamples()));
+        }
+
+        streamer.stop();
+
+        // Long enough for the healthy sinks; the dead one just runs it out
+        return streamer.finishSession(1500);
+    }
+};
+
+static UploadSinkTests uploadSinkTests;